@@ -0,0 +1,48 @@
+#ifndef RL_BIOME_HPP
+#define RL_BIOME_HPP
+
+#include <voxel.hpp>
+
+#include <cstdint>
+
+enum class Biome : uint8_t {
+    PLAINS,
+
+    // Hot and dry: flat sand.
+    DESERT,
+
+    // Cold: high, steep and rocky.
+    HIGHLANDS,
+
+    // Hot and humid: bare stone.
+    WASTES
+};
+
+// What a biome does to the terrain. Height parameters are blended between
+// neighbouring biomes, materials aren't.
+struct BiomeInfo {
+    const char* name;
+
+    // Top voxel of a column, and the `filler_depth` voxels under it.
+    VoxelType surface;
+    VoxelType filler;
+    int filler_depth;
+
+    // Surface height is `min_height + height_offset + relief * height_scale`,
+    // where relief is the terrain noise's height above `min_height`.
+    float height_offset;
+    float height_scale;
+
+    // Average boulders per chunk.
+    float boulders;
+};
+
+/**
+ * @brief Biome of a climate. `temperature` and `humidity` are climate noise
+ * values, roughly within [-1, 1].
+ */
+auto classify_biome(float temperature, float humidity) -> Biome;
+
+auto get_biome_info(Biome biome) -> const BiomeInfo&;
+
+#endif
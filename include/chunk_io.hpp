@@ -0,0 +1,210 @@
+#ifndef RL_CHUNK_IO_HPP
+#define RL_CHUNK_IO_HPP
+
+#include <voxel.hpp>
+#include <region_file.hpp>
+#include <io_backend.hpp>
+#include <memory_stats.hpp>
+
+#include <unordered_map>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string>
+#include <iosfwd>
+#include <cstdint>
+
+// Power-of-two bucketed latency histogram, bucket i counts samples in
+// [2^i, 2^(i+1)) microseconds.
+struct LatencyHistogram {
+    static constexpr int BucketCount = 32;
+
+    void record(std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Upper bound (in microseconds) of the bucket containing the
+     * `p`th percentile, `p` in [0, 1].
+     */
+    auto get_percentile(double p) const -> uint64_t;
+
+    uint64_t buckets[BucketCount] = {};
+    uint64_t count = 0;
+};
+
+// Asynchronous chunk persistence on top of `RegionStorage`. Requests are
+// batched and handed to an `IoBackend` once per `poll()`, and the results
+// come back from the same call, so callers never block on the disk.
+//
+// Saves write the payload into freshly reserved space first and the header
+// entry second, so the previous copy stays valid until the new one is
+// complete. Only one header write per chunk is in flight at a time, and a
+// save counts as finished once a header at least as new as its own is on
+// disk. Loads of a chunk with a save still in flight are served from the
+// pending payload.
+class ChunkIO {
+public:
+    struct Settings {
+        // Operations in flight at once. NVMe drives need a deep queue to
+        // reach full throughput.
+        unsigned int queue_depth = 256;
+
+        // Use the portable thread-pool backend even where io_uring exists.
+        bool force_thread_pool = false;
+    };
+
+    struct Completion {
+        enum class Type : uint8_t {
+            LOAD,
+            SAVE
+        };
+
+        Type type;
+        ChunkPosition position;
+
+        // Loads: false if the chunk was never stored. Saves: false on failure.
+        bool success;
+
+        // Loads only, the stored payload (see `RegionFile::decode_chunk`).
+        std::vector<uint8_t> payload;
+    };
+
+    struct Stats {
+        LatencyHistogram load_latency;
+        LatencyHistogram save_latency;
+        uint64_t loads = 0;
+        uint64_t saves = 0;
+        uint64_t failures = 0;
+    };
+
+    ChunkIO(RegionStorage& storage, Settings settings);
+    explicit ChunkIO(RegionStorage& storage);
+
+    /**
+     * @brief Waits for every in-flight operation to finish.
+     */
+    ~ChunkIO();
+
+    ChunkIO(const ChunkIO&) = delete;
+    ChunkIO& operator=(const ChunkIO&) = delete;
+
+    void request_load(ChunkPosition pos);
+    void request_save(ChunkPosition pos, std::vector<uint8_t> payload);
+
+    /**
+     * @brief Submits queued requests and returns everything that finished
+     * since the last call.
+     */
+    auto poll() -> std::vector<Completion>;
+
+    /**
+     * @brief Blocks until all queued and in-flight requests have finished.
+     * Their completions are returned by the next `poll()`.
+     */
+    void wait_idle();
+
+    auto get_pending_count() const -> size_t {
+        return requests.size();
+    }
+
+    /**
+     * @brief Sequence number of the most recent `request_save()`, 0 if there
+     * was none yet.
+     */
+    auto get_last_save_sequence() const -> uint64_t {
+        return next_save_sequence - 1;
+    }
+
+    /**
+     * @brief Whether every save up to and including `sequence` has finished.
+     */
+    auto is_saved_through(uint64_t sequence) const -> bool;
+
+    auto get_backend_name() const -> const char* {
+        return backend->get_name();
+    }
+
+    auto get_storage() -> RegionStorage& {
+        return storage;
+    }
+
+    void print_stats(std::ostream& out) const;
+
+    Stats stats;
+
+private:
+    struct Request {
+        enum class Stage : uint8_t {
+            READ_PAYLOAD,
+            WRITE_PAYLOAD,
+            WRITE_HEADER
+        };
+
+        Stage stage;
+        ChunkPosition position;
+        RegionFile* file;
+        RegionFile::Entry entry;
+
+        // Loads read into `buffer`, saves write `payload` and then the
+        // header entry from `buffer`.
+        std::vector<uint8_t> buffer;
+        std::shared_ptr<std::vector<uint8_t>> payload;
+        MemoryCharge buffer_memory{ MemoryCategory::IO_BUFFERS, 0 };
+        uint64_t save_sequence = 0;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // Payload shared with the save request, which carries its memory charge.
+    struct PendingSave {
+        uint64_t sequence;
+        std::shared_ptr<const std::vector<uint8_t>> payload;
+    };
+
+    struct HeaderState {
+        // Sequence of the newest entry set in memory, and of the last header
+        // write started.
+        uint64_t published = 0;
+        uint64_t written = 0;
+        bool writing = false;
+
+        // Saves with their payload on disk, waiting for a header at least as
+        // new as their own.
+        std::vector<uint64_t> waiting;
+    };
+
+    void queue_op(uint64_t id);
+    void submit_queued();
+    void handle_result(const IoResult& result);
+    void finish_payload(uint64_t id, bool success);
+    void finish_header(uint64_t id, bool success);
+
+    // Starts writing the newest entry of a chunk, unless a header write for
+    // it is in flight already or nothing newer was published.
+    void write_header(HeaderState& state);
+
+    void finish(uint64_t id, bool success);
+
+    static auto get_key(ChunkPosition pos) -> std::string;
+
+    RegionStorage& storage;
+    std::unique_ptr<IoBackend> backend;
+
+    uint64_t next_id = 1;
+    uint64_t next_save_sequence = 1;
+    std::unordered_map<uint64_t, Request> requests;
+
+    // Requests waiting for a free slot in the backend queue.
+    std::deque<uint64_t> queued;
+    unsigned int in_flight = 0;
+
+    // Latest save per chunk key, for read-after-write and for ordering
+    // overlapping saves of the same chunk.
+    std::unordered_map<std::string, PendingSave> pending_saves;
+
+    // Header writes per chunk key, kept while any save of it waits for one.
+    std::unordered_map<std::string, HeaderState> headers;
+
+    std::vector<Completion> completions;
+};
+
+#endif
@@ -3,18 +3,24 @@
 
 #include <voxel.hpp>
 #include <world.hpp>
+#include <memory_stats.hpp>
+#include <visibility.hpp>
 
-#include <siv/PerlinNoise.hpp>
+#include <noise_source.hpp>
 #include <glad/gl.h>
 
+#include <memory>
 #include <vector>
 
 // Vertex data for each voxel, with position (x, y, z), texture coordinates (u, v), 
-// and normals (nx, ny, nz)
+// normals (nx, ny, nz) and the light the face gets, packed as sky level * 16
+// + block level. Kept apart so the shader can dim the sky for the time of
+// day without a remesh.
 struct Vertex {
     float x, y, z;
     float u, v;
     float nx, ny, nz; 
+    float light;
 };
 
 // A chunk mesh. Vertex and index buffers saved here for redundancy, might
@@ -26,18 +32,54 @@ struct ChunkMesh {
     // Destroy buffers and set buffer IDs to 0.
     void destroy_buffers();
 
+    // Charge `vertices`/`indices` to the memory stats, once they're complete.
+    void account_cpu_memory();
+
+    // Free `vertices`/`indices`, e.g. once the GPU has its own copy.
+    void release_cpu_memory();
+
     std::vector<Vertex> vertices;
     std::vector<GLuint> indices;
 
+    // Where each section's faces start in `indices`, the last entry is where
+    // they end. Faces are added section by section, so a section can be
+    // drawn on its own.
+    uint32_t section_offsets[Chunk::SectionCount + 1] = {};
+
+    SectionConnectivity section_connectivity[Chunk::SectionCount];
+    ChunkOccluders occluders;
+
+    MemoryCharge cpu_memory{ MemoryCategory::MESH_CPU, 0 };
+    MemoryCharge cpu_overhead{ MemoryCategory::ALLOCATOR_OVERHEAD, 0 };
+    MemoryCharge gpu_memory{ MemoryCategory::MESH_GPU, 0 };
+
     GLuint vao = 0;
     GLuint vbo = 0;
     GLuint ebo = 0;
 };
 
+// Pinned versions of a chunk and its six neighbours, everything a mesher
+// reads. Edits made while it's held go to new copies of the chunks, so a
+// mesh job on another thread never sees a half-applied edit.
+struct ChunkSnapshot {
+    static auto pin(const World& world, ChunkPosition pos) -> ChunkSnapshot;
+
+    std::shared_ptr<const Chunk> chunk;
+
+    // Missing neighbours are null.
+    std::shared_ptr<const Chunk> x_left, x_right;
+    std::shared_ptr<const Chunk> y_bottom, y_top;
+    std::shared_ptr<const Chunk> z_back, z_front;
+};
+
 class ChunkMesher {
 public:
     explicit ChunkMesher(const Chunk* chunk, World* world=nullptr, UVOffsetScheme*s=nullptr);
 
+    // Meshes a pinned snapshot. Safe to use off the main thread as long as
+    // `snapshot` outlives the mesher.
+    ChunkMesher(const ChunkSnapshot& snapshot, const UVOffsetScheme* s);
+
     // Builds a chunk mesh. Internal GL buffers are not initialized by default and
     // must be initialized after the ChunkMesh object is created. 
     // TODO: Refactor this so that ChunkMesh::create_gl_buffers() returns a low-level
@@ -50,11 +92,20 @@ private:
 
     void add_voxel_single_chunk(ChunkMesh& mesh, int x, int y, int z);
 
+    // Packed light (see `Vertex`) of the voxel at (x, y, z), which may be
+    // one past the chunk's bounds. Faces take the light of the voxel they
+    // face.
+    auto get_face_light(int x, int y, int z) const -> float;
+
+    // Whether `section` is solid and every voxel around it is too, using the
+    // neighbours' occupancy flags instead of looking at their voxels.
+    auto is_section_buried(int section) const -> bool;
+
     const Chunk* chunk;
     World* world = nullptr;
 
     // TODO: Move this to a GL mesher wrapper
-    UVOffsetScheme* uv_scheme = nullptr;
+    const UVOffsetScheme* uv_scheme = nullptr;
 
     // Chunk caches prevent chunk lookup during meshing
     const Chunk* cache_chunk_x_left = nullptr;
@@ -64,7 +115,8 @@ private:
     const Chunk* cache_chunk_y_bottom = nullptr;
     const Chunk* cache_chunk_y_top = nullptr;
 
-    siv::PerlinNoise perlin{ 123456u };
+    // For texture variation.
+    const NoiseSource* texture_noise = nullptr;
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,127 @@
+#ifndef RL_CHUNK_PIPELINE_HPP
+#define RL_CHUNK_PIPELINE_HPP
+
+#include <voxel.hpp>
+
+#include <unordered_map>
+#include <string>
+
+// Stages a chunk goes through on its way to the screen, in order. A chunk's
+// stage is the last one it has completed.
+enum class ChunkStage : uint8_t {
+    NONE,
+
+    // Solid terrain and caves.
+    TERRAIN,
+
+    // Biome materials on the terrain.
+    SURFACE,
+
+    // The chunk's own features are placed, the ones spilling into its
+    // neighbours are queued for them (see `DecorationQueue`).
+    DECORATION,
+
+    // Every neighbour is decorated, so nothing can spill into the chunk
+    // anymore and its voxels are final. Sky and block light are computed
+    // (see `compute_skylight`, `compute_blocklight`).
+    LIGHT,
+
+    // Meshed on a worker thread...
+    MESH,
+
+    // ...and uploaded on the GL thread.
+    UPLOAD
+};
+
+auto get_stage_name(ChunkStage stage) -> const char*;
+
+/**
+ * @brief Stage every horizontal neighbour (diagonals included) of a chunk
+ * has to reach before `stage` may run on it, NONE if it doesn't depend on
+ * its neighbours.
+ */
+auto get_neighbour_requirement(ChunkStage stage) -> ChunkStage;
+
+// Tracks the stage of every chunk, and the stage each chunk is wanted at
+// (its target). Requesting a target pulls in the neighbours the stages up to
+// it depend on, at the stage they need: a chunk wanted on screen needs its
+// neighbours lit, which needs theirs decorated. So every chunk that gets
+// generated is one some visible chunk depends on, and the scheduler (see
+// `ChunkStreamer`) can run a stage as soon as `can_run` says its neighbours
+// are ready, however far along other chunks are.
+//
+// Chunks only move forward, until they're erased on unload. Main thread only.
+class ChunkPipeline {
+public:
+    struct Entry {
+        ChunkPosition position;
+        ChunkStage stage = ChunkStage::NONE;
+        ChunkStage target = ChunkStage::NONE;
+
+        // Only wanted for a prefetched chunk.
+        bool prefetch = false;
+    };
+
+    /**
+     * @brief Drops every target, e.g. before requesting the ones for a new
+     * camera position. Chunks without a stage are forgotten.
+     */
+    void clear_targets();
+
+    /**
+     * @brief Wants the chunk at `pos` at `target` at least, and its
+     * neighbours at whatever the stages up to it require.
+     */
+    void request(ChunkPosition pos, ChunkStage target, bool prefetch = false);
+
+    auto get_stage(ChunkPosition pos) const -> ChunkStage;
+    auto get_target(ChunkPosition pos) const -> ChunkStage;
+
+    /**
+     * @brief Whether the chunk at `pos` is only wanted for a prefetch.
+     */
+    auto is_prefetch(ChunkPosition pos) const -> bool;
+
+    /**
+     * @brief Records that the chunk at `pos` reached `stage`. Also used to
+     * step back, e.g. to LIGHT once a chunk's mesh is dropped.
+     */
+    void set_stage(ChunkPosition pos, ChunkStage stage);
+
+    /**
+     * @brief Forgets the chunk at `pos`, once it unloads.
+     */
+    void erase(ChunkPosition pos);
+
+    /**
+     * @brief Whether `stage` may run on the chunk at `pos` now: the chunk
+     * completed the stage before it, wants `stage`, and its neighbours meet
+     * the stage's requirement.
+     */
+    auto can_run(ChunkPosition pos, ChunkStage stage) const -> bool;
+
+    auto get_entries() const -> const std::unordered_map<std::string, Entry>& {
+        return entries;
+    }
+
+    /**
+     * @brief Chunks at each stage, indexed by `ChunkStage`, for stats.
+     */
+    void count_stages(size_t (&counts)[static_cast<int>(ChunkStage::UPLOAD) + 1]) const;
+
+    // The 8 horizontal neighbours stages depend on.
+    static constexpr ChunkPosition neighbours[] = {
+        { -1, 0, -1 }, { 0, 0, -1 }, { 1, 0, -1 },
+        { -1, 0, 0 }, { 1, 0, 0 },
+        { -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 }
+    };
+
+private:
+    auto find(ChunkPosition pos) const -> const Entry*;
+
+    static auto get_key(ChunkPosition pos) -> std::string;
+
+    std::unordered_map<std::string, Entry> entries;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef RL_CHUNK_PREFETCHER_HPP
+#define RL_CHUNK_PREFETCHER_HPP
+
+#include <voxel.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+// Predicts where the camera is heading so the streamer can generate and mesh
+// chunks before they enter the load radius. Fast flight easily outruns
+// distance-ordered loading, which shows up as holes in front of the camera.
+class ChunkPrefetcher {
+public:
+    struct Settings {
+        // How far ahead (in seconds of travel at the current velocity) to prefetch.
+        float lookahead_seconds = 1.5f;
+
+        // Radius (in chunks) around each predicted point that gets prefetched.
+        int path_radius = 2;
+
+        // Below this speed (blocks per second) the camera is considered
+        // stationary and nothing is prefetched.
+        float min_speed = 8.0f;
+
+        // Weight of the look direction versus the velocity direction when
+        // predicting the path. Strafing keeps velocity dominant, turning
+        // while flying bends the path towards where the camera looks.
+        float look_weight = 0.25f;
+
+        // Exponential smoothing factor for velocity, in (0, 1]. 1 uses only
+        // the latest frame, which jitters with frame times.
+        float velocity_smoothing = 0.2f;
+    };
+
+    struct Stats {
+        // Columns that entered the load radius already meshed because they
+        // were prefetched.
+        uint64_t hits = 0;
+
+        // Columns that entered the load radius without a mesh.
+        uint64_t misses = 0;
+
+        // Chunks generated by the prefetcher ahead of the load radius.
+        uint64_t prefetched = 0;
+
+        // Prefetched chunks unloaded without ever entering the load radius.
+        uint64_t wasted = 0;
+    };
+
+    ChunkPrefetcher() = default;
+    explicit ChunkPrefetcher(Settings settings) : settings{settings} {}
+
+    /**
+     * @brief Feeds the camera position for this frame. `dt` is the time in
+     * seconds since the previous call.
+     */
+    void observe(glm::vec3 camera_pos, glm::vec3 camera_front, float dt);
+
+    /**
+     * @brief Returns columns along the predicted camera path, nearest first.
+     * Positions have `y = 0`. Empty when the camera is not moving fast enough.
+     */
+    auto get_path_columns() const -> std::vector<ChunkPosition>;
+
+    auto get_velocity() const -> glm::vec3 {
+        return velocity;
+    }
+
+    Settings settings;
+    Stats stats;
+
+private:
+    glm::vec3 last_pos = {};
+    glm::vec3 front = { 0.0f, 0.0f, -1.0f };
+    glm::vec3 velocity = {};
+    bool has_last_pos = false;
+};
+
+#endif
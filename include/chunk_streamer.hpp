@@ -0,0 +1,393 @@
+#ifndef RL_CHUNK_STREAMER_HPP
+#define RL_CHUNK_STREAMER_HPP
+
+#include <voxel.hpp>
+#include <world.hpp>
+#include <chunk_mesh.hpp>
+#include <chunk_prefetcher.hpp>
+#include <chunk_io.hpp>
+#include <edit_journal.hpp>
+#include <world_gen.hpp>
+#include <column_cache.hpp>
+#include <decoration.hpp>
+#include <chunk_pipeline.hpp>
+#include <lighting.hpp>
+#include <frustum_culler.hpp>
+#include <occlusion_culler.hpp>
+#include <thread_pool.hpp>
+
+#include <glm/glm.hpp>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <string>
+
+// A chunk mesh that has been uploaded to the GPU, along with the chunk it
+// was built from. CPU-side vertex/index vectors are cleared after upload,
+// so the index count is kept separately for drawing.
+struct CoordChunkMesh {
+    ChunkMesh mesh;
+    ChunkPosition position;
+    size_t indices;
+
+    // Box around the vertices, relative to `get_origin()`. Tighter than the
+    // chunk, nothing above the terrain or in buried sections has faces.
+    glm::vec3 bounds_min{ 0.0f };
+    glm::vec3 bounds_max{ 0.0f };
+
+    /**
+     * @brief Where the mesh is drawn, its vertices are relative to this.
+     */
+    auto get_origin() const -> glm::vec3 {
+        return { Chunk::Width * position.x + 1, Chunk::Height * position.y, Chunk::Width * position.z + 1 };
+    }
+};
+
+// A mesh with some of its sections visible, one bit per section.
+struct VisibleChunk {
+    const CoordChunkMesh* mesh;
+    uint16_t sections;
+};
+
+// Loads, generates, meshes and uploads chunks around the camera, and unloads
+// chunks that fall out of range. The world is streamed in columns along x/z;
+// every column spans `World::world_size.y` chunks vertically.
+//
+// Every chunk moves through the stages of a `ChunkPipeline`. The columns in
+// the load radius (and along the prefetch path) are wanted on screen, which
+// pulls in the rings around them at the stages meshes depend on, and nothing
+// else gets generated. A stage is started as soon as its neighbourhood is
+// ready, so jobs for every stage run side by side on the thread pool.
+//
+// Chunks are generated and meshed on the pool, meshes from pinned chunk
+// snapshots (see `ChunkSnapshot`). Everything else happens on the calling
+// (GL) thread and is budgeted per call to `update()`, so the frame rate
+// stays bounded while the world fills in. Generation is deterministic, so
+// the order jobs finish in doesn't matter. Features spilling across chunk
+// borders go through a `DecorationQueue`, so a chunk never waits for its
+// neighbours to generate either. Edits never wait for mesh jobs:
+// they copy the chunk if a job has it pinned, and a remesh replaces the old
+// mesh once it's done. Columns along the predicted camera path are
+// prefetched up to the unload radius, see `ChunkPrefetcher`.
+//
+// With a `ChunkIO`, chunks are loaded from disk asynchronously when present,
+// and edited chunks are saved when they unload. In `SaveMode::FULL` generated
+// chunks are saved too, so revisiting an area never re-runs worldgen; in
+// `SaveMode::DELTA` only the edits are stored. The render thread never waits
+// on the disk.
+//
+// With an `EditJournal` as well, every edit made through `set_voxel()` is
+// journaled, and the streamer checkpoints the journal whenever it is due by
+// saving all edited chunks.
+class ChunkStreamer {
+public:
+    struct Settings {
+        // Columns within this radius (in chunks) of the camera are meshed and drawn.
+        int load_radius = 16;
+
+        // Columns beyond this radius are unloaded. Must be larger than
+        // `load_radius`, otherwise chunks on the border would thrash.
+        int unload_radius = 20;
+
+        // Generation jobs started per update, and in flight at once.
+        int max_generated_per_update = 16;
+        int max_generate_jobs = 64;
+
+        // Mesh jobs started per update, and in flight at once.
+        int max_meshed_per_update = 8;
+        int max_mesh_jobs = 64;
+
+        // Threads running generation and mesh jobs. 0 uses one thread per
+        // core, minus the main thread.
+        unsigned int worker_threads = 0;
+
+        // Disk loads requested but not yet completed.
+        int max_pending_loads = 256;
+
+        // How strongly chunks in front of the camera are preferred over
+        // chunks behind it. 0 orders work by distance only.
+        float view_weight = 1.0f;
+    };
+
+    ChunkStreamer(World& world, UVOffsetScheme& uv_scheme, Settings settings,
+        ChunkIO* io = nullptr, EditJournal* journal = nullptr);
+    ChunkStreamer(World& world, UVOffsetScheme& uv_scheme);
+    ~ChunkStreamer();
+
+    ChunkStreamer(const ChunkStreamer&) = delete;
+    ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+    /**
+     * @brief Advances streaming for the current camera state. Unloads far
+     * columns, then spends this update's budget on the highest-priority
+     * generation and meshing work.
+     */
+    void update(glm::vec3 camera_pos, glm::vec3 camera_front);
+
+    /**
+     * @brief Saves edited chunks, then unloads every chunk and mesh owned by
+     * the streamer.
+     */
+    void unload_all();
+
+    /**
+     * @brief Edits a loaded voxel and remeshes the affected chunks. Returns
+     * false if the voxel isn't loaded.
+     */
+    auto set_voxel(Position pos, VoxelType type) -> bool;
+
+    /**
+     * @brief Rewrites a loaded chunk as a full snapshot, dropping its edit
+     * history. Returns false if the chunk isn't loaded or there's no storage.
+     */
+    auto compact_chunk(ChunkPosition pos) -> bool;
+
+    auto get_meshes() const -> const std::unordered_map<std::string, CoordChunkMesh>& {
+        return meshes;
+    }
+
+    /**
+     * @brief Appends the meshes at least partly inside `frustum` to
+     * `visible`, see `ChunkCuller`. Empty meshes are left out.
+     */
+    void get_visible_meshes(const Frustum& frustum, std::vector<const CoordChunkMesh*>& visible) const;
+
+    /**
+     * @brief Appends the meshes with sections a line of sight from
+     * `camera_pos` can reach to `visible`.
+     *
+     * Walks breadth-first from the camera's section to its neighbours
+     * inside `frustum`. A section is left through a face only if its air
+     * connects that face to the one it was entered through (see
+     * `SectionConnectivity`), and never back against a direction already
+     * taken, so the walk can't wrap around behind solid rock. Sections of
+     * chunks without a mesh block the way. With the camera outside the
+     * meshed world it falls back to `get_visible_meshes`.
+     */
+    void get_visible_sections(const Frustum& frustum, const glm::vec3& camera_pos, std::vector<VisibleChunk>& visible) const;
+
+    /**
+     * @brief Appends occluders for `OcclusionCuller` from the meshed chunks
+     * within `radius` columns of `camera_pos`, see `ChunkOccluders`.
+     */
+    void get_occluders(const glm::vec3& camera_pos, int radius, std::vector<OcclusionBox>& occluders) const;
+
+    Settings settings;
+    ChunkPrefetcher prefetcher;
+
+    // Column fields shared by the generation jobs of stacked chunks.
+    ColumnCache column_cache;
+
+    // Feature voxels for the chunks they spilled into.
+    DecorationQueue decorations;
+
+    // Stage of every chunk, and the stage it's wanted at.
+    ChunkPipeline pipeline;
+
+    // Boxes of the meshes that have something to draw.
+    ChunkCuller culler;
+
+private:
+    struct WorkItem {
+        float priority;
+        ChunkPosition position;
+
+        // std::priority_queue is a max-heap, lowest priority value goes first.
+        bool operator<(const WorkItem& other) const {
+            return priority > other.priority;
+        }
+    };
+
+    // How many columns past a mesh the chunks it depends on reach: its
+    // neighbours have to be lit, which needs theirs decorated.
+    static constexpr int DependencyRadius = 2;
+
+    auto get_priority(ChunkPosition pos) const -> float;
+    auto is_column_in_radius(ChunkPosition pos, int radius) const -> bool;
+
+    // Wants the load radius on screen, and the prefetch path ahead of it.
+    void update_targets();
+
+    void rebuild_queues();
+    void unload_far_chunks();
+
+    // Counts prefetch hits and misses for columns that entered the load
+    // radius when the camera moved from `old_chunk` to `camera_chunk`.
+    void record_prefetch_results(ChunkPosition old_chunk);
+
+    // Starts a generation job for the chunk at `pos`.
+    void generate_chunk(ChunkPosition pos, bool prefetch);
+
+    // Adds the chunks generated since the last update to the world.
+    void add_generated_chunks();
+
+    // Applies feature voxels that arrived after their chunk was generated.
+    void apply_late_decorations();
+
+    // Starts a light job for the chunk at `pos`. A job started later for the
+    // same chunk supersedes this one.
+    void light_chunk(ChunkPosition pos);
+
+    // Stores the light computed since the last update, which moves the
+    // chunks on to meshing.
+    void apply_light_results();
+
+    // Relights the lit chunks that voxels changed in the chunk at `pos`
+    // can shed light on right away, and remeshes wherever the light changed.
+    // The changes lie within local x `min_x` to `max_x` and z `min_z` to
+    // `max_z`. Chunks with a light job running get a new one instead.
+    void relight_around(ChunkPosition pos, int min_x, int max_x, int min_z, int max_z);
+
+    // Like `relight_around` for a single voxel at local (x, y, z) that was
+    // `old_type`, but updates the light incrementally (see `LightEditor`).
+    void relight_voxel(ChunkPosition pos, int x, int y, int z, VoxelType old_type);
+
+    void add_chunk(std::shared_ptr<Chunk> chunk, bool prefetch);
+
+    // Queues a save for `chunk` if it has changes that aren't on disk yet.
+    void save_chunk(Chunk* chunk);
+
+    // Handles finished disk loads: decoded chunks are added, chunks that
+    // aren't on disk go back into the generation queue. Failed saves are
+    // remembered for the journal checkpoint.
+    void process_io_completions();
+
+    // Starts a journal checkpoint when one is due, and finishes the running
+    // one once its saves have completed.
+    void update_checkpoint();
+    void finish_checkpoint();
+    // Starts a mesh job for the chunk at `pos`. A job started later for the
+    // same chunk supersedes this one.
+    void mesh_chunk(ChunkPosition pos);
+    void remesh_chunk(ChunkPosition pos);
+
+    // Uploads the meshes finished since the last update.
+    void upload_meshes();
+
+    // Runs or queues whatever stages became ready around `pos` now that
+    // the chunk there moved forward.
+    void advance_stages(ChunkPosition pos);
+
+    World& world;
+    UVOffsetScheme& uv_scheme;
+    const WorldGenerator& generator;
+    ChunkIO* io = nullptr;
+    EditJournal* journal = nullptr;
+
+    // Last save the running checkpoint has to wait for.
+    uint64_t checkpoint_save_sequence = 0;
+    bool checkpoint_running = false;
+
+    // A save failed since the last finished checkpoint, so the journal
+    // can't be trusted to be redundant.
+    bool save_failed = false;
+
+    // A failed save of a chunk that was unloaded already can't be retried,
+    // the journal holds the only copy of its edits. No checkpoint finishes
+    // after that, so the next start replays every generation in order.
+    bool save_lost = false;
+
+    std::unordered_map<std::string, CoordChunkMesh> meshes;
+
+    struct MeshResult {
+        std::string key;
+        ChunkPosition position;
+        uint64_t ticket;
+        ChunkMesh mesh;
+    };
+
+    struct MeshJob {
+        uint64_t ticket;
+        ChunkPosition position;
+
+        // Set when a newer job supersedes this one, so it's skipped if it
+        // hasn't started yet.
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    // Mesh jobs in flight, by chunk key. Only the result with the latest
+    // ticket for a chunk is kept.
+    std::unordered_map<std::string, MeshJob> meshing;
+    uint64_t next_mesh_ticket = 1;
+
+    std::mutex mesh_results_mutex;
+    std::vector<MeshResult> mesh_results;
+
+    struct GenerateJob {
+        ChunkPosition position;
+        bool prefetch;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    struct GenerateResult {
+        std::string key;
+        std::shared_ptr<Chunk> chunk;
+    };
+
+    // Generation jobs in flight, by chunk key. Results for chunks that are no
+    // longer in here were cancelled and are dropped.
+    std::unordered_map<std::string, GenerateJob> generating;
+
+    std::mutex generate_results_mutex;
+    std::vector<GenerateResult> generate_results;
+
+    struct LightJob {
+        uint64_t ticket;
+        ChunkPosition position;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+    };
+
+    struct LightResult {
+        std::string key;
+        ChunkPosition position;
+        uint64_t ticket;
+        std::unique_ptr<Chunk::LightLevels> skylight;
+        std::unique_ptr<Chunk::LightLevels> blocklight;
+    };
+
+    // Light jobs in flight, by chunk key, like `meshing`.
+    std::unordered_map<std::string, LightJob> lighting;
+    uint64_t next_light_ticket = 1;
+
+    std::mutex light_results_mutex;
+    std::vector<LightResult> light_results;
+
+    // Late feature voxels whose chunk is still on its way into the world.
+    std::vector<FeatureSpill> late_decorations;
+
+    std::priority_queue<WorkItem> generate_queue;
+    std::priority_queue<WorkItem> mesh_queue;
+
+    // Keys of chunks generated ahead of the load radius by the prefetcher.
+    // Entries are dropped once the chunk enters the load radius or unloads.
+    std::unordered_set<std::string> prefetched_chunks;
+
+    // Chunks with a disk load in flight, and whether it was a prefetch.
+    std::unordered_map<std::string, bool> pending_loads;
+
+    // Chunks known to be absent from disk, generated without asking again.
+    std::unordered_map<std::string, ChunkPosition> missing_on_disk;
+
+    std::chrono::steady_clock::time_point last_update_time = {};
+
+    ChunkPosition camera_chunk = {};
+    glm::vec3 camera_pos = {};
+    glm::vec3 camera_front = { 0.0f, 0.0f, -1.0f };
+
+    // Camera state the work queues were last built for. Queues are only
+    // rebuilt when the camera changes chunk or turns far enough.
+    ChunkPosition queued_camera_chunk = {};
+    glm::vec3 queued_camera_front = {};
+    bool queues_valid = false;
+
+    // Declared last so jobs finish before the state they report into goes away.
+    ThreadPool workers;
+};
+
+#endif
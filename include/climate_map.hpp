@@ -0,0 +1,97 @@
+#ifndef RL_CLIMATE_MAP_HPP
+#define RL_CLIMATE_MAP_HPP
+
+#include <voxel.hpp>
+#include <biome.hpp>
+#include <noise_source.hpp>
+
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <string>
+
+// Biome of a column, with the height parameters of the biomes around it
+// blended in, see `BiomeInfo`.
+struct ColumnBiome {
+    Biome biome;
+    float height_offset;
+    float height_scale;
+};
+
+// Temperature and humidity for biome selection. Climate changes over
+// hundreds of voxels, so the noise is only sampled every `Step` voxels,
+// a region of `RegionChunks` x `RegionChunks` chunk columns at a time,
+// and regions are cached. Columns bilinearly interpolate the climate of the
+// lattice points around them for their biome, and the biomes' height
+// parameters for their height, so heights change smoothly across biome
+// borders while materials switch sharply. No noise is evaluated per column.
+//
+// Safe to use from several generation jobs at once, like `ColumnCache`.
+class ClimateMap {
+public:
+    static constexpr int Step = 16;
+    static constexpr int RegionChunks = 8;
+    static constexpr int RegionSize = RegionChunks * Chunk::Width;
+
+    static_assert(RegionSize % Step == 0 && Chunk::Width % Step == 0);
+
+    /**
+     * @brief `scale` is the climate noise frequency per voxel. Keeps up to
+     * `capacity` regions.
+     */
+    ClimateMap(const NoiseSource& temperature, const NoiseSource& humidity,
+        float scale, int octaves, size_t capacity = 256);
+
+    ClimateMap(const ClimateMap&) = delete;
+    ClimateMap& operator=(const ClimateMap&) = delete;
+
+    /**
+     * @brief Biome of the column at world (`x`, `z`).
+     */
+    auto get_column(int x, int z) const -> ColumnBiome;
+
+    /**
+     * @brief Biomes of every column of the chunk column containing `pos`,
+     * indexed [x][z]. Only x and z of `pos` are used.
+     */
+    void get_columns(ChunkPosition pos, ColumnBiome (&out)[Chunk::Width][Chunk::Width]) const;
+
+private:
+    static constexpr int Points = RegionSize / Step + 1;
+
+    // Lattice points on a region's far edges are shared with the next
+    // region, so interpolation never has to look at two regions.
+    struct Region {
+        std::once_flag computed;
+        float temperature[Points][Points];
+        float humidity[Points][Points];
+        float height_offset[Points][Points];
+        float height_scale[Points][Points];
+    };
+
+    struct Entry {
+        std::shared_ptr<Region> region;
+        std::list<std::string>::iterator lru_position;
+    };
+
+    auto get_region(int region_x, int region_z) const -> std::shared_ptr<const Region>;
+    void compute_region(Region& region, int region_x, int region_z) const;
+
+    // Column at (`x`, `z`) within `region`, in voxels.
+    static auto blend(const Region& region, int x, int z) -> ColumnBiome;
+
+    const NoiseSource& temperature;
+    const NoiseSource& humidity;
+    float scale;
+    int octaves;
+    size_t capacity;
+
+    mutable std::mutex mutex;
+
+    // Region keys, most recently used first.
+    mutable std::list<std::string> lru;
+    mutable std::unordered_map<std::string, Entry> entries;
+};
+
+#endif
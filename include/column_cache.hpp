@@ -0,0 +1,72 @@
+#ifndef RL_COLUMN_CACHE_HPP
+#define RL_COLUMN_CACHE_HPP
+
+#include <voxel.hpp>
+#include <world_gen.hpp>
+
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <string>
+
+// Caches the 2D fields (`ColumnFields`) of chunk columns, so the noise behind
+// them is evaluated once per column instead of once per stacked chunk. Safe
+// to use from several generation jobs at once: the first job to ask for a
+// column computes it, jobs asking for the same column meanwhile wait for it.
+//
+// Columns are evicted least recently used first once the cache is over
+// capacity, preferring columns whose chunks have all been generated. Columns
+// still being worked on are only evicted when nothing else can be.
+class ColumnCache {
+public:
+    /**
+     * @brief `chunks_per_column` is how many chunks are stacked on a
+     * column, i.e. `World::world_size.y`.
+     */
+    ColumnCache(const WorldGenerator& generator, int chunks_per_column, size_t capacity = 2048);
+
+    ColumnCache(const ColumnCache&) = delete;
+    ColumnCache& operator=(const ColumnCache&) = delete;
+
+    /**
+     * @brief Fields of the column containing `pos`, computed on a miss. Each
+     * call counts as one chunk of the column being generated.
+     */
+    auto get(ChunkPosition pos) -> std::shared_ptr<const ColumnFields>;
+
+    struct Stats {
+        std::atomic<uint64_t> hits = 0;
+        std::atomic<uint64_t> misses = 0;
+        std::atomic<uint64_t> evictions = 0;
+    };
+
+    Stats stats;
+
+private:
+    struct Column {
+        std::once_flag computed;
+        ColumnFields fields;
+    };
+
+    struct Entry {
+        std::shared_ptr<Column> column;
+        std::list<std::string>::iterator lru_position;
+        int chunks_generated = 0;
+    };
+
+    void evict();
+
+    const WorldGenerator& generator;
+    int chunks_per_column;
+    size_t capacity;
+
+    std::mutex mutex;
+
+    // Column keys, most recently used first.
+    std::list<std::string> lru;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+#endif
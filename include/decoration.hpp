@@ -0,0 +1,136 @@
+#ifndef RL_DECORATION_HPP
+#define RL_DECORATION_HPP
+
+#include <voxel.hpp>
+
+#include <functional>
+#include <unordered_map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+// One voxel of a feature (ore vein, boulder, ...), in coordinates local to
+// the chunk it lands in. Only replaces voxels of type `replace`, so features
+// never cut into terrain or each other in ways they aren't meant to.
+struct FeatureVoxel {
+    uint8_t x;
+    uint8_t y;
+    uint8_t z;
+    VoxelType type;
+    VoxelType replace;
+};
+
+// Feature voxels the decoration of chunk `source` spilled into chunk
+// `target`.
+struct FeatureSpill {
+    ChunkPosition source;
+    ChunkPosition target;
+    std::vector<FeatureVoxel> voxels;
+};
+
+// `Chunk::spill_sources` with every neighbour's bit set.
+constexpr uint16_t AllSpillSources = 0x1ef;
+
+/**
+ * @brief Bit of `Chunk::spill_sources` for spill from `source`, a
+ * horizontal neighbour of `target`.
+ */
+auto get_spill_bit(ChunkPosition source, ChunkPosition target) -> uint16_t;
+
+/**
+ * @brief Writes `spill` into `chunk`, its target, as generated terrain (see
+ * `Chunk::set_generated_voxel`): spill is part of the baseline delta saves
+ * are stored against, and doesn't make the chunk dirty. Does nothing if
+ * `chunk` has the source's spill already. Edited voxels are left alone, and
+ * where spill from two chunks overlaps the greater ore wins, so the result
+ * doesn't depend on which arrives first. Returns whether any voxel changed.
+ */
+auto apply_feature_spill(Chunk& chunk, const FeatureSpill& spill) -> bool;
+
+// Feature voxels for the chunks they belong to. A chunk's generation job
+// `claim`s whatever its neighbours spilled into it so far; voxels pushed for
+// a chunk after it claimed are "late" and handed to the main thread through
+// `take_late`, which applies them to the loaded chunk. So features cross
+// chunk borders without ever generating a neighbour early or waiting for
+// one, whatever order chunks are generated in.
+//
+// Claiming doesn't take the voxels out: a chunk that unloads and comes back
+// gets them again, even if the neighbours they came from never unloaded.
+// Each source keeps only its latest spill, so nothing piles up while chunks
+// come and go, and `evict` drops what's left once a chunk is out of range.
+//
+// The queue is split into shards by chunk, each with its own mutex, so
+// generation jobs only contend when they touch the same chunks.
+class DecorationQueue {
+public:
+    DecorationQueue() = default;
+
+    DecorationQueue(const DecorationQueue&) = delete;
+    DecorationQueue& operator=(const DecorationQueue&) = delete;
+
+    /**
+     * @brief Queues `spill` for its target, in place of anything its source
+     * spilled there before.
+     */
+    void push(FeatureSpill spill);
+
+    /**
+     * @brief Returns the spill queued for the chunk at `pos` and marks it as
+     * generated, so later pushes for it become late.
+     */
+    auto claim(ChunkPosition pos) -> std::vector<FeatureSpill>;
+
+    /**
+     * @brief Forgets that the chunk at `pos` claimed, e.g. once it unloads.
+     * Its spill stays queued for the next claim.
+     */
+    void release(ChunkPosition pos);
+
+    /**
+     * @brief Drops the spill of every chunk `is_needed` returns false for.
+     */
+    void evict(const std::function<bool(ChunkPosition)>& is_needed);
+
+    /**
+     * @brief Drops everything, late voxels included.
+     */
+    void clear();
+
+    /**
+     * @brief Voxels pushed for chunks after they claimed, since the last call.
+     */
+    auto take_late() -> std::vector<FeatureSpill>;
+
+    /**
+     * @brief Feature voxels queued, claimed or not, for stats.
+     */
+    auto get_pending_count() const -> size_t;
+
+private:
+    static constexpr int ShardCount = 16;
+
+    struct Entry {
+        ChunkPosition target;
+
+        // One per chunk that spilled into the target.
+        std::vector<FeatureSpill> spills;
+        bool claimed = false;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, Entry> entries;
+    };
+
+    auto get_shard(ChunkPosition pos) -> Shard&;
+
+    static auto get_key(ChunkPosition pos) -> std::string;
+
+    Shard shards[ShardCount];
+
+    std::mutex late_mutex;
+    std::vector<FeatureSpill> late;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef RL_EDIT_JOURNAL_HPP
+#define RL_EDIT_JOURNAL_HPP
+
+#include <voxel.hpp>
+#include <region_file.hpp>
+
+#include <condition_variable>
+#include <filesystem>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <span>
+#include <cstdio>
+#include <cstdint>
+
+// Append-only log of voxel edits, so edits survive a crash without rewriting
+// whole chunks. `append()` only buffers the edit; a background thread writes
+// everything buffered since the last commit and fsyncs once per
+// `commit_interval` (group commit), so an edit is at most one interval away
+// from being durable.
+//
+// The journal is split into generations, `journal.N.bin` in the world
+// directory. A checkpoint seals the current generation and starts a new one.
+// Once every chunk edited in the sealed generation has been saved to its
+// region file, `finish_checkpoint()` fsyncs the region files and deletes the
+// sealed generation. Generations left over from a crash are applied to the
+// region files by `replay()` on startup.
+class EditJournal {
+public:
+    struct Settings {
+        std::chrono::milliseconds commit_interval{ 50 };
+
+        // A checkpoint is due once the current generation is this big or
+        // this old, whichever comes first.
+        size_t checkpoint_bytes = 4 << 20;
+        std::chrono::seconds checkpoint_interval{ 60 };
+    };
+
+    // One journaled edit, stored as is. The checksum covers the other fields
+    // and catches torn writes at the end of a generation.
+    struct Record {
+        int32_t x;
+        int32_t y;
+        int32_t z;
+        uint8_t type;
+        uint8_t padding[3];
+        uint32_t checksum;
+    };
+
+    EditJournal(std::filesystem::path directory, Settings settings);
+    explicit EditJournal(std::filesystem::path directory);
+
+    /**
+     * @brief Commits everything appended so far and finishes any pending
+     * checkpoint work.
+     */
+    ~EditJournal();
+
+    EditJournal(const EditJournal&) = delete;
+    EditJournal& operator=(const EditJournal&) = delete;
+
+    auto is_open() const -> bool;
+
+    void append(Position pos, VoxelType type);
+
+    /**
+     * @brief Blocks until every edit appended so far is durable.
+     */
+    void commit();
+
+    /**
+     * @brief Applies the generations left over from a previous run to the
+     * region files in `storage` and deletes them. Call once on startup,
+     * before any chunk is loaded. Returns the number of edits replayed.
+     */
+    auto replay(RegionStorage& storage) -> size_t;
+
+    auto is_checkpoint_due() const -> bool;
+
+    /**
+     * @brief Seals the current generation. Edits appended from now on go to a
+     * new one. The caller then saves every chunk with unsaved edits.
+     */
+    void begin_checkpoint();
+
+    /**
+     * @brief Deletes the sealed generations in the background once `files`
+     * have been fsynced. Only call after the saves started by the checkpoint
+     * have completed.
+     */
+    void finish_checkpoint(std::vector<RegionFile*> files);
+
+    /**
+     * @brief Ends the checkpoint without deleting anything, for when some of
+     * its saves failed. The sealed generations are deleted by the next
+     * checkpoint that succeeds.
+     */
+    void abandon_checkpoint();
+
+    auto is_checkpointing() const -> bool {
+        return checkpointing;
+    }
+
+    struct Stats {
+        std::atomic<uint64_t> records = 0;
+        std::atomic<uint64_t> commits = 0;
+        std::atomic<uint64_t> checkpoints = 0;
+    };
+
+    Stats stats;
+
+private:
+    void commit_loop(std::stop_token stop);
+
+    // Writes and fsyncs `records` to `file`. Runs on the commit thread.
+    auto write_records(std::FILE* out, std::span<const Record> records) -> bool;
+
+    auto get_generation_path(uint64_t generation) const -> std::filesystem::path;
+    auto open_generation(uint64_t generation) -> std::FILE*;
+
+    std::filesystem::path directory;
+    Settings settings;
+
+    // Generations found on disk at startup, oldest first.
+    std::vector<uint64_t> leftover_generations;
+
+    // Open generation, written by the commit thread only.
+    std::FILE* file = nullptr;
+    bool opened = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable_any condition;
+
+    // Everything below is guarded by `mutex`.
+    uint64_t generation = 0;
+    std::chrono::steady_clock::time_point generation_start;
+    size_t generation_bytes = 0;
+
+    std::vector<Record> pending;
+    uint64_t appended = 0;
+    uint64_t committed = 0;
+    bool commit_requested = false;
+
+    // Set by `begin_checkpoint()`. The first `rotate_split` pending records
+    // still belong to the sealed generation.
+    std::FILE* next_file = nullptr;
+    size_t rotate_split = 0;
+    bool rotate_requested = false;
+
+    // Sealed and not deleted yet, oldest first. Once `retaining` is set after
+    // a failed region sync, nothing is deleted until the next start.
+    std::vector<uint64_t> sealed_generations;
+    bool retaining = false;
+    std::vector<RegionFile*> checkpoint_files;
+    bool checkpoint_ready = false;
+    std::atomic<bool> checkpointing = false;
+
+    // Declared last so the thread stops before the state above goes away.
+    std::jthread commit_thread;
+};
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef RL_FRUSTUM_CULLER_HPP
+#define RL_FRUSTUM_CULLER_HPP
+
+#include <voxel.hpp>
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// The six planes bounding what a camera sees, facing inwards: a point p is
+// on the inner side of plane (a, b, c, d) when a*x + b*y + c*z + d >= 0.
+struct Frustum {
+    /**
+     * @brief Extracts the planes from a projection * view matrix.
+     */
+    static auto from_matrix(const glm::mat4& view_projection) -> Frustum;
+
+    /**
+     * @brief Whether the box from `min` to `max` is at least partly inside,
+     * one box at a time. Like `ChunkCuller`, boxes near a corner may pass.
+     */
+    auto intersects(const glm::vec3& min, const glm::vec3& max) const -> bool;
+
+    glm::vec4 planes[6];
+};
+
+// Axis-aligned boxes of chunk meshes, tested against a frustum in SIMD
+// batches (see `NoiseLanes::SimdOps`). Boxes are grouped by column into
+// cells of `CellWidth` x `CellWidth` columns with a box around all of
+// them. Cells are tested first: a cell outside the frustum drops all its
+// chunks, one inside takes them all, and only cells crossing a plane have
+// their chunks tested one by one. Main thread only.
+class ChunkCuller {
+public:
+    static constexpr int CellWidth = 8;
+
+    /**
+     * @brief Adds the chunk at `pos` with the world space box from `min` to
+     * `max`, or moves its box if it's there already.
+     */
+    void insert(ChunkPosition pos, const glm::vec3& min, const glm::vec3& max);
+
+    void erase(ChunkPosition pos);
+
+    void clear();
+
+    /**
+     * @brief Appends the chunks whose boxes are at least partly inside
+     * `frustum` to `visible`. Boxes near a corner of the frustum may pass
+     * without being visible, none that are visible get dropped.
+     */
+    void cull(const Frustum& frustum, std::vector<ChunkPosition>& visible) const;
+
+    auto get_count() const -> size_t {
+        return count;
+    }
+
+private:
+    // Boxes as structure of arrays, padded with empty lanes to a whole
+    // number of batches.
+    struct Boxes {
+        std::vector<float> min_x, min_y, min_z;
+        std::vector<float> max_x, max_y, max_z;
+
+        void resize(size_t size);
+        void set(size_t index, const glm::vec3& min, const glm::vec3& max);
+    };
+
+    struct Cell {
+        std::vector<ChunkPosition> positions;
+        Boxes boxes;
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    enum class Containment : uint8_t { OUTSIDE, CROSSING, INSIDE };
+
+    // Tests the first `size` of `boxes` against `frustum`.
+    static void test_boxes(const Frustum& frustum, const Boxes& boxes, size_t size,
+        std::vector<Containment>& out);
+
+    static void update_bounds(Cell& cell);
+
+    static auto get_cell_key(ChunkPosition pos) -> int64_t;
+
+    std::unordered_map<int64_t, Cell> cells;
+    size_t count = 0;
+};
+
+#endif
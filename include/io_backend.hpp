@@ -0,0 +1,64 @@
+#ifndef RL_IO_BACKEND_HPP
+#define RL_IO_BACKEND_HPP
+
+#include <region_file.hpp>
+
+#include <memory>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// A positional read or write against a region file. The buffer must stay
+// alive until the matching `IoResult` has been returned from `poll()`.
+struct IoOp {
+    enum class Type : uint8_t {
+        READ,
+        WRITE
+    };
+
+    Type type;
+    RegionFile* file;
+    uint64_t offset;
+    uint8_t* buffer;
+    uint32_t length;
+    uint64_t user_data;
+};
+
+struct IoResult {
+    uint64_t user_data;
+    bool success;
+};
+
+// Asynchronous executor for batches of `IoOp`s. Short transfers are retried
+// internally, so a successful result always covers the whole buffer.
+// Not thread-safe: submit and poll from one thread.
+class IoBackend {
+public:
+    virtual ~IoBackend() = default;
+
+    virtual auto get_name() const -> const char* = 0;
+
+    /**
+     * @brief Maximum number of operations that may be in flight at once.
+     * Submitting more than that is a bug.
+     */
+    virtual auto get_queue_depth() const -> unsigned int = 0;
+
+    virtual void submit(std::span<const IoOp> ops) = 0;
+
+    /**
+     * @brief Appends finished operations to `out` without blocking.
+     */
+    virtual void poll(std::vector<IoResult>& out) = 0;
+};
+
+/**
+ * @brief Creates the fastest backend available on this platform: io_uring on
+ * Linux when the kernel allows it, a thread pool doing blocking positional
+ * I/O everywhere else.
+ */
+auto create_io_backend(unsigned int queue_depth) -> std::unique_ptr<IoBackend>;
+
+auto create_thread_pool_io_backend(unsigned int queue_depth) -> std::unique_ptr<IoBackend>;
+
+#endif
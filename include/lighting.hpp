@@ -0,0 +1,108 @@
+#ifndef RL_LIGHTING_HPP
+#define RL_LIGHTING_HPP
+
+#include <voxel.hpp>
+#include <world.hpp>
+
+#include <memory>
+#include <vector>
+
+// Pinned versions of a chunk and its 8 horizontal neighbours, everything
+// lighting the chunk reads. Indexed [dx + 1][dz + 1], missing chunks are
+// null.
+struct LightSnapshot {
+    static auto pin(const World& world, ChunkPosition pos) -> LightSnapshot;
+
+    auto get_chunk() const -> const Chunk* {
+        return chunks[1][1].get();
+    }
+
+    std::shared_ptr<const Chunk> chunks[3][3];
+};
+
+/**
+ * @brief Computes the sky light of the chunk in the middle of `snapshot`.
+ *
+ * Every voxel at or above its column's heightmap sees the sky and gets
+ * `Chunk::MaxLight`. From there light floods into the air around it, one
+ * level less per voxel, under overhangs and into cave mouths. The flood is a
+ * breadth-first search seeded only where a sky column borders a taller one,
+ * so flat ground costs next to nothing. It crosses chunk borders: light
+ * travels at most 14 voxels, so nothing past the 8 neighbours can reach the
+ * chunk. Missing neighbours pass no light, chunks stacked above aren't
+ * looked at.
+ */
+void compute_skylight(const LightSnapshot& snapshot, Chunk::LightLevels& out);
+
+/**
+ * @brief Computes the block light of the chunk in the middle of `snapshot`:
+ * light from emitting voxels (see `get_light_emission`) in it and its
+ * neighbours, flooded through air one level less per voxel. Chunks without
+ * emitters nearby are skipped.
+ */
+void compute_blocklight(const LightSnapshot& snapshot, Chunk::LightLevels& out);
+
+// Updates the light of a chunk and its 8 horizontal neighbours in place
+// after single voxel edits, instead of recomputing whole chunks. Only voxels
+// whose light depends on the edit are visited: new light spreads out
+// breadth-first, light that lost its source is cleared breadth-first while
+// the brighter voxels at the edge of the cleared area are collected, and
+// those refill it afterwards. Results match `compute_skylight` and
+// `compute_blocklight`.
+//
+// Chunks are only made writable (see `World::get_writable_chunk`) once
+// their light changes. Main thread only.
+class LightEditor {
+public:
+    LightEditor(World& world, ChunkPosition pos);
+
+    /**
+     * @brief Updates both light channels after the voxel at local (x, y, z)
+     * of the middle chunk changed from `old_type` to what it is now.
+     */
+    void update(int x, int y, int z, VoxelType old_type);
+
+    /**
+     * @brief Sections of the chunk at offset (dx, dz), one bit each, with
+     * faces whose light changed. Chunks with none don't need a remesh.
+     */
+    auto get_changed_sections(int dx, int dz) const -> uint16_t {
+        return changed[dx + 1][dz + 1];
+    }
+
+private:
+    enum class Channel : uint8_t { SKY, BLOCK };
+
+    // A voxel in region coordinates: the middle chunk starts at
+    // (Chunk::Width, Chunk::Width).
+    struct Node {
+        int16_t x;
+        int16_t y;
+        int16_t z;
+        uint8_t level;
+    };
+
+    auto get_chunk(int px, int pz, int& x, int& z) const -> Chunk*;
+    auto is_air(int px, int y, int pz) const -> bool;
+    auto get_level(Channel channel, int px, int y, int pz) const -> uint8_t;
+    void set_level(Channel channel, int px, int y, int pz, uint8_t level);
+
+    // Clears the light queued in `removals` and everything it lit, queues
+    // the voxels that keep theirs in `increases`.
+    void remove(Channel channel);
+
+    // Spreads the light queued in `increases`.
+    void spread(Channel channel);
+
+    World& world;
+    ChunkPosition position;
+
+    Chunk* chunks[3][3] = {};
+    bool writable[3][3] = {};
+    uint16_t changed[3][3] = {};
+
+    std::vector<Node> removals;
+    std::vector<Node> increases;
+};
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef RL_MEMORY_STATS_HPP
+#define RL_MEMORY_STATS_HPP
+
+#include <utility>
+#include <memory>
+#include <iosfwd>
+#include <cstdint>
+#include <cstddef>
+
+enum class MemoryCategory : uint8_t {
+    // Chunk objects: voxels plus per-chunk metadata.
+    VOXEL_STORAGE,
+
+    // Vertex/index vectors of meshes that haven't been uploaded yet.
+    MESH_CPU,
+
+    // Vertex/index buffers uploaded to the GPU.
+    MESH_GPU,
+
+    // Texture images on the GPU, mipmaps included.
+    TEXTURES,
+
+    // Encoded chunk payloads of loads and saves in flight, and the copies
+    // kept of pending saves.
+    IO_BUFFERS,
+
+    // Memory that is allocated but holds nothing: unused vector capacity and
+    // per-allocation bookkeeping of tracked heap objects.
+    ALLOCATOR_OVERHEAD
+};
+
+// Process-wide byte counters per `MemoryCategory`. Counters are atomic, so
+// allocation sites on any thread may update them.
+namespace MemoryStats {
+    constexpr int CategoryCount = 6;
+
+    void add(MemoryCategory category, int64_t bytes);
+
+    auto get(MemoryCategory category) -> int64_t;
+    auto get_total() -> int64_t;
+    auto get_category_name(MemoryCategory category) -> const char*;
+
+    /**
+     * @brief Prints every category (in MiB) on one line.
+     */
+    void print(std::ostream& out);
+}
+
+// Accounts `bytes` to a category for as long as the charge is alive. Owners
+// keep one per allocation and reset or destroy it when the memory goes away.
+class MemoryCharge {
+public:
+    MemoryCharge() = default;
+    MemoryCharge(MemoryCategory category, int64_t bytes);
+    ~MemoryCharge();
+
+    MemoryCharge(MemoryCharge&& other) noexcept
+        : category{other.category}, bytes{std::exchange(other.bytes, 0)} {}
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+
+    /**
+     * @brief Releases the current charge, then charges `bytes` instead.
+     */
+    void reset(int64_t new_bytes = 0);
+
+    auto get_bytes() const -> int64_t {
+        return bytes;
+    }
+
+private:
+    MemoryCategory category = MemoryCategory::VOXEL_STORAGE;
+    int64_t bytes = 0;
+};
+
+// Member that accounts `sizeof (Owner)` bytes for every live `Owner`,
+// copies included. Assigning an `Owner` doesn't change the count.
+template <MemoryCategory Category, typename Owner>
+struct MemoryTag {
+    MemoryTag() {
+        MemoryStats::add(Category, sizeof (Owner));
+    }
+
+    MemoryTag(const MemoryTag&) : MemoryTag() {}
+
+    MemoryTag& operator=(const MemoryTag&) {
+        return *this;
+    }
+
+    ~MemoryTag() {
+        MemoryStats::add(Category, -static_cast<int64_t>(sizeof (Owner)));
+    }
+};
+
+// Allocator accounting whatever a container allocates to `Category`, for
+// containers that grow one element at a time or get copied along with their
+// owner, where keeping a `MemoryCharge` in sync would be a chore.
+template <typename T, MemoryCategory Category>
+struct MemoryAllocator {
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = MemoryAllocator<U, Category>;
+    };
+
+    MemoryAllocator() = default;
+
+    template <typename U>
+    MemoryAllocator(const MemoryAllocator<U, Category>&) {}
+
+    auto allocate(size_t count) -> T* {
+        MemoryStats::add(Category, static_cast<int64_t>(count * sizeof (T)));
+        return std::allocator<T>{}.allocate(count);
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        MemoryStats::add(Category, -static_cast<int64_t>(count * sizeof (T)));
+        std::allocator<T>{}.deallocate(pointer, count);
+    }
+
+    template <typename U>
+    bool operator==(const MemoryAllocator<U, Category>&) const {
+        return true;
+    }
+};
+
+#endif
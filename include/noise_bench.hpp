@@ -0,0 +1,15 @@
+#ifndef RL_NOISE_BENCH_HPP
+#define RL_NOISE_BENCH_HPP
+
+#include <iosfwd>
+
+/**
+ * @brief Times a representative terrain noise graph evaluated fused (one
+ * SIMD loop, see noise_graph.hpp), fused one sample at a time, and node by
+ * node through virtual calls like an interpreter would. Prints the results
+ * and whether all three agree bit for bit, then times each `NoiseBackend`
+ * against `siv::PerlinNoise`. Run with `--bench-noise`.
+ */
+void run_noise_benchmark(std::ostream& out);
+
+#endif
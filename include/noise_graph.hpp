@@ -0,0 +1,188 @@
+#ifndef RL_NOISE_GRAPH_HPP
+#define RL_NOISE_GRAPH_HPP
+
+#include <noise_lanes.hpp>
+#include <noise_source.hpp>
+
+#include <cstddef>
+#include <span>
+
+// Compile-time noise graphs for worldgen. A graph is a tree of the node types
+// below, nested by value and built with the helper functions, e.g.
+//
+//     auto height = Noise::clamp(Noise::sum(
+//         Noise::spline(Noise::Octaves{ &base, 0.0007f, 8 }, { -1, 0, 1 }, { 200, 80, 200 }),
+//         Noise::scale(Noise::Octaves{ &detail, 0.02f, 3 }, 6.0f)), 0.0f, 255.0f);
+//
+// Every node is a plain struct with an `eval<Ops>(x, z)` template, so
+// `Noise::evaluate()` compiles the whole tree into a single loop over SIMD
+// lanes, without virtual calls or intermediate buffers. Trying another
+// terrain shape is editing the expression and recompiling.
+//
+// Nodes only use `NoiseLanes` operations, so results are bitwise identical
+// between scalar and SIMD lanes, like the `NoiseSource` backends.
+namespace Noise {
+    template <typename Ops>
+    using Lanes = typename Ops::F;
+
+    // Octave noise of `source` at (x, z) * `frequency`, the same values
+    // `source->octave2D` gives with `frequency` as scale. The backend is a
+    // branch per vector, which always goes the same way.
+    struct Octaves {
+        const NoiseSource* source;
+        float frequency;
+        int octaves = 1;
+        float persistence = 0.5f;
+
+        template <typename Ops>
+        auto eval(Lanes<Ops> x, Lanes<Ops> z) const -> Lanes<Ops> {
+            const auto f = Ops::set(frequency);
+            const auto* perm = source->get_permutation();
+
+            if (source->get_backend() == NoiseBackend::SIMPLEX) {
+                return NoiseLanes::simplex_octaves2D<Ops>(perm, Ops::mul(x, f), Ops::mul(z, f), octaves, persistence);
+            }
+            return NoiseLanes::octaves<Ops>(perm, Ops::mul(x, f), Ops::mul(z, f),
+                Ops::set(NoiseLanes::plane_z), false, octaves, persistence);
+        }
+    };
+
+    struct Constant {
+        float value;
+
+        template <typename Ops>
+        auto eval(Lanes<Ops>, Lanes<Ops>) const -> Lanes<Ops> {
+            return Ops::set(value);
+        }
+    };
+
+    template <typename A, typename B>
+    struct Sum {
+        A a;
+        B b;
+
+        template <typename Ops>
+        auto eval(Lanes<Ops> x, Lanes<Ops> z) const -> Lanes<Ops> {
+            return Ops::add(a.template eval<Ops>(x, z), b.template eval<Ops>(x, z));
+        }
+    };
+
+    // `a * factor + offset`.
+    template <typename A>
+    struct Scale {
+        A a;
+        float factor;
+        float offset;
+
+        template <typename Ops>
+        auto eval(Lanes<Ops> x, Lanes<Ops> z) const -> Lanes<Ops> {
+            return Ops::add(Ops::mul(a.template eval<Ops>(x, z), Ops::set(factor)), Ops::set(offset));
+        }
+    };
+
+    // `source` sampled at (x, z) displaced by (`warp_x`, `warp_z`) * `strength`.
+    template <typename Source, typename WarpX, typename WarpZ>
+    struct DomainWarp {
+        Source source;
+        WarpX warp_x;
+        WarpZ warp_z;
+        float strength;
+
+        template <typename Ops>
+        auto eval(Lanes<Ops> x, Lanes<Ops> z) const -> Lanes<Ops> {
+            const auto s = Ops::set(strength);
+            const auto warped_x = Ops::add(x, Ops::mul(warp_x.template eval<Ops>(x, z), s));
+            const auto warped_z = Ops::add(z, Ops::mul(warp_z.template eval<Ops>(x, z), s));
+            return source.template eval<Ops>(warped_x, warped_z);
+        }
+    };
+
+    // Piecewise linear remap of `a` through `N` control points. `inputs` must
+    // be ascending, values past either end map to the end's output.
+    template <typename A, size_t N>
+    struct Spline {
+        static_assert(N >= 2, "A spline needs at least two points.");
+
+        A a;
+        float inputs[N];
+        float outputs[N];
+
+        template <typename Ops>
+        auto eval(Lanes<Ops> x, Lanes<Ops> z) const -> Lanes<Ops> {
+            const auto value = a.template eval<Ops>(x, z);
+            const auto zero = Ops::set(0.0f);
+            const auto one = Ops::set(1.0f);
+
+            // Sum of every segment's rise times how far along it `value` is,
+            // which needs no per-lane branching.
+            auto result = Ops::set(outputs[0]);
+            for (size_t i = 0; i + 1 < N; ++i) {
+                const float inv_width = 1.0f / (inputs[i + 1] - inputs[i]);
+                const auto t = Ops::mul(Ops::sub(value, Ops::set(inputs[i])), Ops::set(inv_width));
+                const auto along = Ops::min(Ops::max(t, zero), one);
+                result = Ops::add(result, Ops::mul(along, Ops::set(outputs[i + 1] - outputs[i])));
+            }
+            return result;
+        }
+    };
+
+    template <typename A>
+    struct Clamp {
+        A a;
+        float min;
+        float max;
+
+        template <typename Ops>
+        auto eval(Lanes<Ops> x, Lanes<Ops> z) const -> Lanes<Ops> {
+            return Ops::min(Ops::max(a.template eval<Ops>(x, z), Ops::set(min)), Ops::set(max));
+        }
+    };
+
+    template <typename A, typename B>
+    auto sum(A a, B b) -> Sum<A, B> {
+        return { a, b };
+    }
+
+    template <typename A>
+    auto scale(A a, float factor, float offset = 0.0f) -> Scale<A> {
+        return { a, factor, offset };
+    }
+
+    template <typename Source, typename WarpX, typename WarpZ>
+    auto warp(Source source, WarpX warp_x, WarpZ warp_z, float strength) -> DomainWarp<Source, WarpX, WarpZ> {
+        return { source, warp_x, warp_z, strength };
+    }
+
+    template <typename A, size_t N>
+    auto spline(A a, const float (&inputs)[N], const float (&outputs)[N]) -> Spline<A, N> {
+        Spline<A, N> node{ a, {}, {} };
+        for (size_t i = 0; i < N; ++i) {
+            node.inputs[i] = inputs[i];
+            node.outputs[i] = outputs[i];
+        }
+        return node;
+    }
+
+    template <typename A>
+    auto clamp(A a, float min, float max) -> Clamp<A> {
+        return { a, min, max };
+    }
+
+    /**
+     * @brief Evaluates `graph` at (`origin_x` + x, `origin_z` + z) for every
+     * x below `width` and z below `depth`, into `out` indexed [x * depth + z].
+     * Coordinates are in voxels, frequencies are part of the graph.
+     */
+    template <typename Graph>
+    void evaluate(const Graph& graph, std::span<float> out, int origin_x, int origin_z, int width, int depth) {
+        for (int x = 0; x < width; ++x) {
+            const float sample_x = static_cast<float>(origin_x + x);
+
+            NoiseLanes::fill_row(out.data() + x * depth, depth, origin_z, 1.0f, [&]<typename Ops>(Ops, Lanes<Ops> z) {
+                return graph.template eval<Ops>(Ops::set(sample_x), z);
+            });
+        }
+    }
+}
+
+#endif
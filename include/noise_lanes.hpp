@@ -0,0 +1,446 @@
+#ifndef RL_NOISE_LANES_HPP
+#define RL_NOISE_LANES_HPP
+
+#include <siv/PerlinNoise.hpp>
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Building blocks of the batched noise code (`NoiseSource` backends,
+// `Noise::` graphs). They're in a header so kernels composed from them inline into
+// a single loop.
+namespace NoiseLanes {
+// Lane operations noise kernels are written against: `ScalarOps` for one
+// sample at a time, `SimdOps` for as many as the build's instruction set
+// allows. Each set must do exactly the same IEEE operations, that's what
+// keeps results bitwise identical between them. `floor` is done by
+// truncating and correcting rather than with the hardware instruction for
+// the same reason. `min`/`max` return `b` unless `a` is strictly smaller
+// (larger), like the SSE instructions.
+struct ScalarOps {
+    using F = float;
+    using I = int32_t;
+    static constexpr int Lanes = 1;
+
+    static F load(const float* p) { return *p; }
+    static void store(float* p, F v) { *p = v; }
+    static F set(float v) { return v; }
+    static I set_int(int32_t v) { return v; }
+
+    static F add(F a, F b) { return a + b; }
+    static F sub(F a, F b) { return a - b; }
+    static F mul(F a, F b) { return a * b; }
+    static F min(F a, F b) { return (a < b) ? a : b; }
+    static F max(F a, F b) { return (a > b) ? a : b; }
+
+    static F floor(F v) {
+        const F t = static_cast<float>(static_cast<int32_t>(v));
+        return (t > v) ? t - 1.0f : t;
+    }
+
+    static I to_int(F v) { return static_cast<int32_t>(v); }
+    static I add_int(I a, I b) { return a + b; }
+    static I and_int(I a, I b) { return a & b; }
+    static I or_int(I a, I b) { return a | b; }
+    static I xor_int(I a, I b) { return a ^ b; }
+    static I less(I a, I b) { return (a < b) ? -1 : 0; }
+    static I less(F a, F b) { return (a < b) ? -1 : 0; }
+    static I equal(I a, I b) { return (a == b) ? -1 : 0; }
+    template <int N> static I shift_left(I a) { return a << N; }
+
+    // One bit per lane of a comparison mask, lane 0 lowest.
+    static int to_bits(I mask) { return mask ? 1 : 0; }
+
+    static I lookup(const int32_t* table, I index) { return table[index]; }
+
+    static F select(I mask, F a, F b) { return mask ? a : b; }
+    static F xor_bits(F v, I bits) {
+        return std::bit_cast<float>(std::bit_cast<int32_t>(v) ^ bits);
+    }
+};
+
+#if defined(__AVX2__)
+struct SimdOps {
+    using F = __m256;
+    using I = __m256i;
+    static constexpr int Lanes = 8;
+
+    static F load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, F v) { _mm256_storeu_ps(p, v); }
+    static F set(float v) { return _mm256_set1_ps(v); }
+    static I set_int(int32_t v) { return _mm256_set1_epi32(v); }
+
+    static F add(F a, F b) { return _mm256_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm256_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm256_mul_ps(a, b); }
+    static F min(F a, F b) { return _mm256_min_ps(a, b); }
+    static F max(F a, F b) { return _mm256_max_ps(a, b); }
+
+    static F floor(F v) {
+        const F t = _mm256_cvtepi32_ps(_mm256_cvttps_epi32(v));
+        return _mm256_sub_ps(t, _mm256_and_ps(_mm256_cmp_ps(t, v, _CMP_GT_OQ), set(1.0f)));
+    }
+
+    static I to_int(F v) { return _mm256_cvttps_epi32(v); }
+    static I add_int(I a, I b) { return _mm256_add_epi32(a, b); }
+    static I and_int(I a, I b) { return _mm256_and_si256(a, b); }
+    static I or_int(I a, I b) { return _mm256_or_si256(a, b); }
+    static I xor_int(I a, I b) { return _mm256_xor_si256(a, b); }
+    static I less(I a, I b) { return _mm256_cmpgt_epi32(b, a); }
+    static I less(F a, F b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+    static I equal(I a, I b) { return _mm256_cmpeq_epi32(a, b); }
+    template <int N> static I shift_left(I a) { return _mm256_slli_epi32(a, N); }
+
+    static int to_bits(I mask) { return _mm256_movemask_ps(_mm256_castsi256_ps(mask)); }
+
+    static I lookup(const int32_t* table, I index) {
+        return _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), index, 4);
+    }
+
+    static F select(I mask, F a, F b) { return _mm256_blendv_ps(b, a, _mm256_castsi256_ps(mask)); }
+    static F xor_bits(F v, I bits) { return _mm256_xor_ps(v, _mm256_castsi256_ps(bits)); }
+};
+#elif defined(__SSE2__) || defined(_M_X64)
+struct SimdOps {
+    using F = __m128;
+    using I = __m128i;
+    static constexpr int Lanes = 4;
+
+    static F load(const float* p) { return _mm_loadu_ps(p); }
+    static void store(float* p, F v) { _mm_storeu_ps(p, v); }
+    static F set(float v) { return _mm_set1_ps(v); }
+    static I set_int(int32_t v) { return _mm_set1_epi32(v); }
+
+    static F add(F a, F b) { return _mm_add_ps(a, b); }
+    static F sub(F a, F b) { return _mm_sub_ps(a, b); }
+    static F mul(F a, F b) { return _mm_mul_ps(a, b); }
+    static F min(F a, F b) { return _mm_min_ps(a, b); }
+    static F max(F a, F b) { return _mm_max_ps(a, b); }
+
+    static F floor(F v) {
+        const F t = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+        return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, v), set(1.0f)));
+    }
+
+    static I to_int(F v) { return _mm_cvttps_epi32(v); }
+    static I add_int(I a, I b) { return _mm_add_epi32(a, b); }
+    static I and_int(I a, I b) { return _mm_and_si128(a, b); }
+    static I or_int(I a, I b) { return _mm_or_si128(a, b); }
+    static I xor_int(I a, I b) { return _mm_xor_si128(a, b); }
+    static I less(I a, I b) { return _mm_cmplt_epi32(a, b); }
+    static I less(F a, F b) { return _mm_castps_si128(_mm_cmplt_ps(a, b)); }
+    static I equal(I a, I b) { return _mm_cmpeq_epi32(a, b); }
+    template <int N> static I shift_left(I a) { return _mm_slli_epi32(a, N); }
+
+    static int to_bits(I mask) { return _mm_movemask_ps(_mm_castsi128_ps(mask)); }
+
+    // No gather before AVX2, look the lanes up one by one.
+    static I lookup(const int32_t* table, I index) {
+        alignas(16) int32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), index);
+        return _mm_setr_epi32(table[lanes[0]], table[lanes[1]], table[lanes[2]], table[lanes[3]]);
+    }
+
+    static F select(I mask, F a, F b) {
+        const F m = _mm_castsi128_ps(mask);
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+    }
+    static F xor_bits(F v, I bits) { return _mm_xor_ps(v, _mm_castsi128_ps(bits)); }
+};
+#else
+using SimdOps = ScalarOps;
+#endif
+
+// The functions below mirror `siv::BasicPerlinNoise` operation for
+// operation, see siv/PerlinNoise.hpp.
+
+template <typename Ops>
+auto fade(typename Ops::F t) -> typename Ops::F {
+    // t * t * t * (t * (t * 6 - 15) + 10)
+    const auto inner = Ops::add(Ops::mul(t, Ops::sub(Ops::mul(t, Ops::set(6.0f)), Ops::set(15.0f))), Ops::set(10.0f));
+    return Ops::mul(Ops::mul(Ops::mul(t, t), t), inner);
+}
+
+template <typename Ops>
+auto lerp(typename Ops::F a, typename Ops::F b, typename Ops::F t) -> typename Ops::F {
+    return Ops::add(a, Ops::mul(Ops::sub(b, a), t));
+}
+
+template <typename Ops>
+auto grad(typename Ops::I hash, typename Ops::F x, typename Ops::F y, typename Ops::F z) -> typename Ops::F {
+    const auto h = Ops::and_int(hash, Ops::set_int(15));
+    const auto u = Ops::select(Ops::less(h, Ops::set_int(8)), x, y);
+    const auto x_or_z = Ops::select(Ops::or_int(Ops::equal(h, Ops::set_int(12)), Ops::equal(h, Ops::set_int(14))), x, z);
+    const auto v = Ops::select(Ops::less(h, Ops::set_int(4)), y, x_or_z);
+
+    // Negating is flipping the sign bit, bits 0 and 1 of the hash pick which.
+    const auto u_sign = Ops::template shift_left<31>(Ops::and_int(h, Ops::set_int(1)));
+    const auto v_sign = Ops::template shift_left<30>(Ops::and_int(h, Ops::set_int(2)));
+    return Ops::add(Ops::xor_bits(u, u_sign), Ops::xor_bits(v, v_sign));
+}
+
+template <typename Ops>
+auto noise(const int32_t* perm, typename Ops::F x, typename Ops::F y, typename Ops::F z) -> typename Ops::F {
+    const auto byte = Ops::set_int(255);
+    const auto one_int = Ops::set_int(1);
+    const auto one = Ops::set(1.0f);
+
+    const auto floor_x = Ops::floor(x);
+    const auto floor_y = Ops::floor(y);
+    const auto floor_z = Ops::floor(z);
+
+    const auto ix = Ops::and_int(Ops::to_int(floor_x), byte);
+    const auto iy = Ops::and_int(Ops::to_int(floor_y), byte);
+    const auto iz = Ops::and_int(Ops::to_int(floor_z), byte);
+
+    const auto fx = Ops::sub(x, floor_x);
+    const auto fy = Ops::sub(y, floor_y);
+    const auto fz = Ops::sub(z, floor_z);
+
+    const auto u = fade<Ops>(fx);
+    const auto v = fade<Ops>(fy);
+    const auto w = fade<Ops>(fz);
+
+    const auto a = Ops::and_int(Ops::add_int(Ops::lookup(perm, ix), iy), byte);
+    const auto b = Ops::and_int(Ops::add_int(Ops::lookup(perm, Ops::add_int(ix, one_int)), iy), byte);
+
+    const auto aa = Ops::and_int(Ops::add_int(Ops::lookup(perm, a), iz), byte);
+    const auto ab = Ops::and_int(Ops::add_int(Ops::lookup(perm, Ops::add_int(a, one_int)), iz), byte);
+    const auto ba = Ops::and_int(Ops::add_int(Ops::lookup(perm, b), iz), byte);
+    const auto bb = Ops::and_int(Ops::add_int(Ops::lookup(perm, Ops::add_int(b, one_int)), iz), byte);
+
+    const auto fx1 = Ops::sub(fx, one);
+    const auto fy1 = Ops::sub(fy, one);
+    const auto fz1 = Ops::sub(fz, one);
+
+    const auto p0 = grad<Ops>(Ops::lookup(perm, aa), fx, fy, fz);
+    const auto p1 = grad<Ops>(Ops::lookup(perm, ba), fx1, fy, fz);
+    const auto p2 = grad<Ops>(Ops::lookup(perm, ab), fx, fy1, fz);
+    const auto p3 = grad<Ops>(Ops::lookup(perm, bb), fx1, fy1, fz);
+    const auto p4 = grad<Ops>(Ops::lookup(perm, Ops::add_int(aa, one_int)), fx, fy, fz1);
+    const auto p5 = grad<Ops>(Ops::lookup(perm, Ops::add_int(ba, one_int)), fx1, fy, fz1);
+    const auto p6 = grad<Ops>(Ops::lookup(perm, Ops::add_int(ab, one_int)), fx, fy1, fz1);
+    const auto p7 = grad<Ops>(Ops::lookup(perm, Ops::add_int(bb, one_int)), fx1, fy1, fz1);
+
+    const auto q0 = lerp<Ops>(p0, p1, u);
+    const auto q1 = lerp<Ops>(p2, p3, u);
+    const auto q2 = lerp<Ops>(p4, p5, u);
+    const auto q3 = lerp<Ops>(p6, p7, u);
+
+    const auto r0 = lerp<Ops>(q0, q1, v);
+    const auto r1 = lerp<Ops>(q2, q3, v);
+
+    return lerp<Ops>(r0, r1, w);
+}
+
+// Octave sum like `siv::perlin_detail::Octave3D`, of `kernel(x, y, z)`. The
+// 2D variants keep `z` fixed instead of scaling it.
+template <typename Ops, typename Kernel>
+auto octave_sum(Kernel&& kernel, typename Ops::F x, typename Ops::F y, typename Ops::F z,
+        bool scale_z, int count, float persistence) -> typename Ops::F {
+    const auto two = Ops::set(2.0f);
+    auto result = Ops::set(0.0f);
+    float amplitude = 1.0f;
+
+    for (int i = 0; i < count; ++i) {
+        result = Ops::add(result, Ops::mul(kernel(x, y, z), Ops::set(amplitude)));
+        x = Ops::mul(x, two);
+        y = Ops::mul(y, two);
+        if (scale_z) {
+            z = Ops::mul(z, two);
+        }
+        amplitude *= persistence;
+    }
+
+    return result;
+}
+
+// Perlin octaves. 2D samples lie on the plane z = `plane_z`.
+template <typename Ops>
+auto octaves(const int32_t* perm, typename Ops::F x, typename Ops::F y, typename Ops::F z,
+        bool scale_z, int count, float persistence) -> typename Ops::F {
+    return octave_sum<Ops>([&](auto x, auto y, auto z) {
+        return noise<Ops>(perm, x, y, z);
+    }, x, y, z, scale_z, count, persistence);
+}
+
+// Simplex noise (Perlin 2001, after Gustavson's "Simplex noise demystified"),
+// using the same permutation tables as Perlin noise. Corners are ordered
+// with masks instead of branches, so lanes never diverge. Output is roughly
+// within [-1, 1] like Perlin noise.
+
+// One of 8 gradients (+-1, +-2), (+-2, +-1), picked by the low bits of `hash`.
+template <typename Ops>
+auto grad2(typename Ops::I hash, typename Ops::F x, typename Ops::F y) -> typename Ops::F {
+    const auto h = Ops::and_int(hash, Ops::set_int(7));
+    const auto low = Ops::less(h, Ops::set_int(4));
+    const auto u = Ops::select(low, x, y);
+    const auto v = Ops::select(low, y, x);
+
+    const auto u_sign = Ops::template shift_left<31>(Ops::and_int(h, Ops::set_int(1)));
+    const auto v_sign = Ops::template shift_left<30>(Ops::and_int(h, Ops::set_int(2)));
+    return Ops::add(Ops::xor_bits(u, u_sign), Ops::xor_bits(Ops::mul(v, Ops::set(2.0f)), v_sign));
+}
+
+// Falloff of a simplex corner at offset (x, y, z) with radius^2 `radius`.
+template <typename Ops>
+auto corner_falloff(float radius, typename Ops::F x, typename Ops::F y, typename Ops::F z) -> typename Ops::F {
+    const auto length = Ops::add(Ops::add(Ops::mul(x, x), Ops::mul(y, y)), Ops::mul(z, z));
+    const auto t = Ops::max(Ops::sub(Ops::set(radius), length), Ops::set(0.0f));
+    const auto t2 = Ops::mul(t, t);
+    return Ops::mul(t2, t2);
+}
+
+template <typename Ops>
+auto simplex2D(const int32_t* perm, typename Ops::F x, typename Ops::F y) -> typename Ops::F {
+    constexpr float Skew = 0.36602540378f;   // (sqrt(3) - 1) / 2
+    constexpr float Unskew = 0.21132486540f; // (3 - sqrt(3)) / 6
+
+    const auto byte = Ops::set_int(255);
+    const auto one_int = Ops::set_int(1);
+    const auto zero = Ops::set(0.0f);
+    const auto one = Ops::set(1.0f);
+
+    // Simplex cell, and the offset from its origin corner.
+    const auto s = Ops::mul(Ops::add(x, y), Ops::set(Skew));
+    const auto cell_x = Ops::floor(Ops::add(x, s));
+    const auto cell_y = Ops::floor(Ops::add(y, s));
+    const auto t = Ops::mul(Ops::add(cell_x, cell_y), Ops::set(Unskew));
+    const auto x0 = Ops::sub(x, Ops::sub(cell_x, t));
+    const auto y0 = Ops::sub(y, Ops::sub(cell_y, t));
+
+    // Lower triangle (x0 > y0) steps along x first, the upper one along y.
+    const auto lower = Ops::less(y0, x0);
+    const auto i1 = Ops::and_int(lower, one_int);
+    const auto j1 = Ops::and_int(Ops::xor_int(lower, Ops::set_int(-1)), one_int);
+    const auto step_x = Ops::select(lower, one, zero);
+
+    const auto x1 = Ops::add(Ops::sub(x0, step_x), Ops::set(Unskew));
+    const auto y1 = Ops::add(Ops::sub(y0, Ops::sub(one, step_x)), Ops::set(Unskew));
+    const auto x2 = Ops::add(Ops::sub(x0, one), Ops::set(2.0f * Unskew));
+    const auto y2 = Ops::add(Ops::sub(y0, one), Ops::set(2.0f * Unskew));
+
+    const auto ii = Ops::and_int(Ops::to_int(cell_x), byte);
+    const auto jj = Ops::and_int(Ops::to_int(cell_y), byte);
+
+    const auto h0 = Ops::lookup(perm, Ops::add_int(ii, Ops::lookup(perm, jj)));
+    const auto h1 = Ops::lookup(perm, Ops::add_int(Ops::add_int(ii, i1), Ops::lookup(perm, Ops::add_int(jj, j1))));
+    const auto h2 = Ops::lookup(perm, Ops::add_int(Ops::add_int(ii, one_int), Ops::lookup(perm, Ops::add_int(jj, one_int))));
+
+    const auto n0 = Ops::mul(corner_falloff<Ops>(0.5f, x0, y0, zero), grad2<Ops>(h0, x0, y0));
+    const auto n1 = Ops::mul(corner_falloff<Ops>(0.5f, x1, y1, zero), grad2<Ops>(h1, x1, y1));
+    const auto n2 = Ops::mul(corner_falloff<Ops>(0.5f, x2, y2, zero), grad2<Ops>(h2, x2, y2));
+
+    return Ops::mul(Ops::add(Ops::add(n0, n1), n2), Ops::set(40.0f));
+}
+
+template <typename Ops>
+auto simplex3D(const int32_t* perm, typename Ops::F x, typename Ops::F y, typename Ops::F z) -> typename Ops::F {
+    constexpr float Skew = 1.0f / 3.0f;
+    constexpr float Unskew = 1.0f / 6.0f;
+
+    const auto byte = Ops::set_int(255);
+    const auto one_int = Ops::set_int(1);
+    const auto all = Ops::set_int(-1);
+    const auto zero = Ops::set(0.0f);
+    const auto one = Ops::set(1.0f);
+
+    const auto s = Ops::mul(Ops::add(Ops::add(x, y), z), Ops::set(Skew));
+    const auto cell_x = Ops::floor(Ops::add(x, s));
+    const auto cell_y = Ops::floor(Ops::add(y, s));
+    const auto cell_z = Ops::floor(Ops::add(z, s));
+    const auto t = Ops::mul(Ops::add(Ops::add(cell_x, cell_y), cell_z), Ops::set(Unskew));
+    const auto x0 = Ops::sub(x, Ops::sub(cell_x, t));
+    const auto y0 = Ops::sub(y, Ops::sub(cell_y, t));
+    const auto z0 = Ops::sub(z, Ops::sub(cell_z, t));
+
+    // Which of the six tetrahedra the sample is in decides the order the
+    // middle corners step along the axes: the second corner steps along
+    // the largest offset, the third along the two largest.
+    const auto xy = Ops::xor_int(Ops::less(x0, y0), all); // x0 >= y0
+    const auto xz = Ops::xor_int(Ops::less(x0, z0), all); // x0 >= z0
+    const auto yz = Ops::xor_int(Ops::less(y0, z0), all); // y0 >= z0
+    const auto yx = Ops::xor_int(xy, all);
+    const auto zx = Ops::xor_int(xz, all);
+    const auto zy = Ops::xor_int(yz, all);
+
+    const auto i1 = Ops::and_int(xy, xz), j1 = Ops::and_int(yx, yz), k1 = Ops::and_int(zx, zy);
+    const auto i2 = Ops::or_int(xy, xz), j2 = Ops::or_int(yx, yz), k2 = Ops::or_int(zx, zy);
+
+    auto offset = [&](typename Ops::F v0, typename Ops::I step, float corner) {
+        return Ops::add(Ops::sub(v0, Ops::select(step, one, zero)), Ops::set(corner * Unskew));
+    };
+
+    const auto x1 = offset(x0, i1, 1.0f), y1 = offset(y0, j1, 1.0f), z1 = offset(z0, k1, 1.0f);
+    const auto x2 = offset(x0, i2, 2.0f), y2 = offset(y0, j2, 2.0f), z2 = offset(z0, k2, 2.0f);
+    const auto x3 = offset(x0, all, 3.0f), y3 = offset(y0, all, 3.0f), z3 = offset(z0, all, 3.0f);
+
+    const auto ii = Ops::and_int(Ops::to_int(cell_x), byte);
+    const auto jj = Ops::and_int(Ops::to_int(cell_y), byte);
+    const auto kk = Ops::and_int(Ops::to_int(cell_z), byte);
+
+    auto hash = [&](typename Ops::I di, typename Ops::I dj, typename Ops::I dk) {
+        const auto k = Ops::lookup(perm, Ops::add_int(kk, Ops::and_int(dk, one_int)));
+        const auto j = Ops::lookup(perm, Ops::add_int(Ops::add_int(jj, Ops::and_int(dj, one_int)), k));
+        return Ops::lookup(perm, Ops::add_int(Ops::add_int(ii, Ops::and_int(di, one_int)), j));
+    };
+
+    const auto none = Ops::set_int(0);
+    const auto n0 = Ops::mul(corner_falloff<Ops>(0.5f, x0, y0, z0), grad<Ops>(hash(none, none, none), x0, y0, z0));
+    const auto n1 = Ops::mul(corner_falloff<Ops>(0.5f, x1, y1, z1), grad<Ops>(hash(i1, j1, k1), x1, y1, z1));
+    const auto n2 = Ops::mul(corner_falloff<Ops>(0.5f, x2, y2, z2), grad<Ops>(hash(i2, j2, k2), x2, y2, z2));
+    const auto n3 = Ops::mul(corner_falloff<Ops>(0.5f, x3, y3, z3), grad<Ops>(hash(all, all, all), x3, y3, z3));
+
+    // Radius^2 0.5 rather than the usual 0.6, which reaches past the
+    // neighbouring simplices and leaves small seams. Scaled up to match.
+    return Ops::mul(Ops::add(Ops::add(Ops::add(n0, n1), n2), n3), Ops::set(72.0f));
+}
+
+template <typename Ops>
+auto simplex_octaves2D(const int32_t* perm, typename Ops::F x, typename Ops::F y,
+        int count, float persistence) -> typename Ops::F {
+    return octave_sum<Ops>([&](auto x, auto y, auto) {
+        return simplex2D<Ops>(perm, x, y);
+    }, x, y, Ops::set(0.0f), false, count, persistence);
+}
+
+template <typename Ops>
+auto simplex_octaves3D(const int32_t* perm, typename Ops::F x, typename Ops::F y, typename Ops::F z,
+        int count, float persistence) -> typename Ops::F {
+    return octave_sum<Ops>([&](auto x, auto y, auto z) {
+        return simplex3D<Ops>(perm, x, y, z);
+    }, x, y, z, true, count, persistence);
+}
+
+// Evaluates one row of `count` samples whose last coordinate runs from
+// `origin` on, full vectors first and the remainder one at a time.
+// `sample(ops, varying)` returns the noise for a vector of the varying
+// coordinate.
+template <typename Sample>
+void fill_row(float* out, int count, int origin, float scale, Sample&& sample) {
+    // Separate bounds for the two loops, so GCC can see neither overruns.
+    const int vector_end = count - count % SimdOps::Lanes;
+    for (int start = 0; start < vector_end; start += SimdOps::Lanes) {
+        float coords[SimdOps::Lanes];
+        for (int lane = 0; lane < SimdOps::Lanes; ++lane) {
+            coords[lane] = static_cast<float>(origin + start + lane) * scale;
+        }
+        SimdOps::store(out + start, sample(SimdOps{}, SimdOps::load(coords)));
+    }
+
+    for (int i = vector_end; i < count; ++i) {
+        out[i] = sample(ScalarOps{}, static_cast<float>(origin + i) * scale);
+    }
+}
+
+// `siv::PerlinNoise::noise2D` samples the plane z = SIVPERLIN_DEFAULT_Z.
+constexpr float plane_z = static_cast<float>(SIVPERLIN_DEFAULT_Z);
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef RL_NOISE_SOURCE_HPP
+#define RL_NOISE_SOURCE_HPP
+
+#include <siv/PerlinNoise.hpp>
+
+#include <memory>
+#include <span>
+#include <cstdint>
+
+enum class NoiseBackend : uint8_t {
+    // Classic Perlin noise, same field as `siv::PerlinNoise` (`PerlinBatch`).
+    PERLIN,
+
+    // Simplex noise, cheaper per sample in 3D and without Perlin's
+    // axis-aligned artifacts (`SimplexBatch`).
+    SIMPLEX
+};
+
+auto get_noise_backend_name(NoiseBackend backend) -> const char*;
+
+// A seeded noise field, evaluated for whole grids of samples at once. Every
+// backend is seeded from the permutation of a `siv::PerlinNoise`, so a seed
+// picks the same table whatever the backend.
+//
+// The virtual functions are per grid, not per sample. Code that needs the
+// noise inlined per sample (`Noise::Octaves`) switches on `get_backend()`
+// and uses the kernels in noise_lanes.hpp directly.
+class NoiseSource {
+public:
+    virtual ~NoiseSource() = default;
+
+    NoiseSource(const NoiseSource&) = delete;
+    NoiseSource& operator=(const NoiseSource&) = delete;
+
+    /**
+     * @brief Octave noise at ((`origin_x` + x) * `scale`, (`origin_z` + z) *
+     * `scale`) for every x below `width` and z below `depth`. `out` holds
+     * `width * depth` values, indexed [x * depth + z].
+     */
+    virtual void octave2D(std::span<float> out, int origin_x, int origin_z, int width, int depth,
+        float scale, int octaves, float persistence = 0.5f) const = 0;
+
+    /**
+     * @brief Octave noise over a `width` x `height` x `depth` grid. `out` is
+     * indexed [(x * height + y) * depth + z].
+     */
+    virtual void octave3D(std::span<float> out, int origin_x, int origin_y, int origin_z,
+        int width, int height, int depth, float scale, int octaves, float persistence = 0.5f) const = 0;
+
+    auto get_backend() const -> NoiseBackend {
+        return backend;
+    }
+
+    auto get_permutation() const -> const int32_t* {
+        return permutation;
+    }
+
+protected:
+    NoiseSource(NoiseBackend backend, const siv::PerlinNoise& perlin);
+
+    NoiseBackend backend;
+
+    // The permutation twice over, so `permutation[i + 1]` needs no wrapping.
+    int32_t permutation[512];
+};
+
+/**
+ * @brief Creates a noise source of the given backend seeded with `seed`.
+ */
+auto make_noise_source(NoiseBackend backend, unsigned int seed) -> std::unique_ptr<NoiseSource>;
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef RL_OCCLUSION_CULLER_HPP
+#define RL_OCCLUSION_CULLER_HPP
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// An axis-aligned box in world space.
+struct OcclusionBox {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+// Software occlusion culling against a low resolution depth buffer. Boxes
+// known to block every line of sight through them are rasterized as
+// occluders, then candidate boxes are tested against the result: one that
+// is behind the occluders at every pixel it covers can be skipped.
+//
+// Occluders write the depth of their back faces, so a line of sight
+// blocked anywhere inside the box counts. Coverage is sampled at pixel
+// centres like on the GPU, which leaves no cracks between neighbouring
+// occluders but can be off by up to half a pixel at their edges.
+// Candidates are tested conservatively, with every pixel their screen
+// rectangle touches and the depth of their nearest corner. Rows are
+// rasterized and tested in SIMD batches (see `NoiseLanes::SimdOps`), and a
+// pyramid of max depths rejects most candidates with a few texel reads.
+//
+// No GL involved, so it can run on any thread. Not thread safe itself.
+class OcclusionCuller {
+public:
+    /**
+     * @brief `width` must be a multiple of 8, both powers of two.
+     */
+    OcclusionCuller(int width, int height);
+
+    /**
+     * @brief Clears the depth buffer for a new view. `camera_pos` picks the
+     * back faces of the occluders.
+     */
+    void begin(const glm::mat4& view_projection, const glm::vec3& camera_pos);
+
+    /**
+     * @brief Rasterizes `box` as an occluder. Boxes crossing the near plane
+     * are skipped.
+     */
+    void add_occluder(const OcclusionBox& box);
+
+    /**
+     * @brief Builds the max depth pyramid, after the last occluder and
+     * before the first test.
+     */
+    void finish_occluders();
+
+    /**
+     * @brief Whether some part of `box` may be in front of the occluders.
+     */
+    auto is_visible(const OcclusionBox& box) const -> bool;
+
+    auto get_width() const -> int {
+        return width;
+    }
+
+    auto get_height() const -> int {
+        return height;
+    }
+
+    /**
+     * @brief Depth at a pixel of the full resolution buffer, normalised
+     * device z, 1 where nothing was drawn.
+     */
+    auto get_depth(int x, int y) const -> float {
+        return levels[0][static_cast<size_t>(y) * width + x];
+    }
+
+private:
+    // A point in screen space: pixels for x and y, normalised device z.
+    struct ScreenPoint {
+        float x, y, z;
+    };
+
+    // Projects `point`, false if it's behind the near plane.
+    auto project(const glm::vec3& point, ScreenPoint& out) const -> bool;
+
+    // Rasterizes a convex, planar quad.
+    void rasterize_quad(const ScreenPoint (&points)[4]);
+
+    int width;
+    int height;
+
+    glm::mat4 view_projection{ 1.0f };
+    glm::vec3 camera_pos{ 0.0f };
+
+    // Level 0 is the depth buffer, each level after it has the max depth
+    // of 2x2 texels of the one before.
+    std::vector<std::vector<float>> levels;
+};
+
+#endif
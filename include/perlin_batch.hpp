@@ -0,0 +1,34 @@
+#ifndef RL_PERLIN_BATCH_HPP
+#define RL_PERLIN_BATCH_HPP
+
+#include <noise_source.hpp>
+
+// Octave Perlin noise evaluated for a whole grid of samples at once, in float
+// and several samples per instruction (AVX2 when built with it, SSE2 on any
+// other x86-64 build, plain scalar code elsewhere). Uses the permutation of a
+// `siv::PerlinNoise` and the same gradients, so it's the same noise field up
+// to float rounding.
+//
+// All code paths do the same float operations in the same order, and FMA
+// contraction is disabled (see CMakeLists.txt), so the output for a seed is
+// bitwise identical whatever the instruction set or grid size.
+class PerlinBatch final : public NoiseSource {
+public:
+    explicit PerlinBatch(const siv::PerlinNoise& perlin);
+
+    /**
+     * @brief Same as `siv::PerlinNoise::octave2D` over the grid, see
+     * `NoiseSource::octave2D`.
+     */
+    void octave2D(std::span<float> out, int origin_x, int origin_z, int width, int depth,
+        float scale, int octaves, float persistence = 0.5f) const override;
+
+    /**
+     * @brief Same as `siv::PerlinNoise::octave3D` over the grid, see
+     * `NoiseSource::octave3D`.
+     */
+    void octave3D(std::span<float> out, int origin_x, int origin_y, int origin_z,
+        int width, int height, int depth, float scale, int octaves, float persistence = 0.5f) const override;
+};
+
+#endif
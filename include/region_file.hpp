@@ -0,0 +1,244 @@
+#ifndef RL_REGION_FILE_HPP
+#define RL_REGION_FILE_HPP
+
+#include <voxel.hpp>
+
+#include <unordered_map>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Position of a region in region coordinates. A region covers
+// `RegionFile::Size` x `RegionFile::Size` chunks along x/z at one chunk y level.
+struct RegionPosition {
+    static auto from_chunk_pos(ChunkPosition pos) -> RegionPosition;
+
+    int x;
+    int y;
+    int z;
+};
+
+// A single region file on disk. Layout:
+//
+//   magic "FERG" | u32 version | Size*Size x { u32 offset, u32 length } | payloads...
+//
+// Offsets are absolute file offsets, a length of 0 means the chunk was never
+// stored. Payloads are either full compressed chunks (see `encode_chunk`) or
+// sparse edits over the generated baseline (see `encode_chunk_delta`). Rewriting a
+// chunk appends a new payload and repoints its header entry; the old payload
+// becomes dead space in the file.
+//
+// Reads go through a read-only memory mapping of the whole file, so loading a
+// chunk is a page-in plus decode. Integers are stored in native byte order
+// (little endian on every platform we ship on).
+class RegionFile {
+public:
+    static constexpr int Size = 32;
+    static constexpr uint32_t Magic = 0x47524546; // "FERG"
+    static constexpr uint32_t Version = 2;
+
+    struct Entry {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    static constexpr size_t HeaderSize = 2 * sizeof (uint32_t) + Size * Size * sizeof (Entry);
+
+    /**
+     * @brief Opens the region file at `path`, creating it with an empty
+     * header if it doesn't exist. Check `is_open()` afterwards.
+     */
+    explicit RegionFile(const std::filesystem::path& path);
+    ~RegionFile();
+
+    RegionFile(const RegionFile&) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+
+    auto is_open() const -> bool;
+
+    auto has_chunk(ChunkPosition pos) const -> bool;
+
+    /**
+     * @brief Decodes the stored chunk at `chunk.position` into `chunk`.
+     * Returns false if the chunk isn't stored or its payload is corrupt.
+     */
+    auto read_chunk(Chunk& chunk) -> bool;
+
+    /**
+     * @brief Stores an already encoded chunk payload at `pos`.
+     */
+    auto write_payload(ChunkPosition pos, const std::vector<uint8_t>& payload) -> bool;
+
+    /**
+     * @brief Encodes and stores `chunk` at `chunk.position`.
+     */
+    auto write_chunk(const Chunk& chunk) -> bool;
+
+    /**
+     * @brief Returns a view of the stored payload for `pos`, or an empty view
+     * if it isn't stored. Valid until the next write to this file.
+     */
+    auto get_payload(ChunkPosition pos) -> std::span<const uint8_t>;
+
+    // Low-level access for asynchronous I/O (see `ChunkIO`). Callers write
+    // payloads to space obtained from `reserve()` and publish them with
+    // `set_entry()` once the write has completed.
+
+    auto get_entry(ChunkPosition pos) const -> Entry;
+
+    /**
+     * @brief Updates the in-memory header entry for `pos`. The on-disk entry
+     * must be written separately, at `get_entry_file_offset(pos)`.
+     */
+    void set_entry(ChunkPosition pos, Entry entry);
+
+    static auto get_entry_file_offset(ChunkPosition pos) -> uint64_t;
+
+    /**
+     * @brief Reserves `length` bytes at the end of the file and returns their
+     * offset. Returns 0 if the file can't grow any further.
+     */
+    auto reserve(uint32_t length) -> uint64_t;
+
+    /**
+     * @brief Flushes written data to the disk. Safe to call from any thread.
+     */
+    auto sync() -> bool;
+
+    // Positional reads/writes, safe to call from any thread.
+    auto read_at(uint64_t offset, void* data, size_t size) const -> bool;
+    auto write_at(uint64_t offset, const void* data, size_t size) -> bool;
+
+#ifndef _WIN32
+    auto get_fd() const -> int {
+        return fd;
+    }
+#endif
+
+    /**
+     * @brief Compresses a chunk, `spill_sources` included, into its on-disk
+     * payload.
+     */
+    static auto encode_chunk(const Chunk& chunk) -> std::vector<uint8_t>;
+
+    /**
+     * @brief Encodes only the edited voxels of `chunk` (`Chunk::edited_voxels`).
+     * Loading such a payload means regenerating the chunk and applying the
+     * edits on top with `apply_chunk_delta`.
+     */
+    static auto encode_chunk_delta(const Chunk& chunk) -> std::vector<uint8_t>;
+
+    static auto is_delta_payload(std::span<const uint8_t> payload) -> bool;
+
+    /**
+     * @brief Decompresses a payload produced by `encode_chunk` into `chunk`
+     * and marks it as a snapshot. `chunk.position` is left untouched. Fails
+     * for delta payloads.
+     */
+    static auto decode_chunk(std::span<const uint8_t> payload, Chunk& chunk) -> bool;
+
+    /**
+     * @brief Applies a payload produced by `encode_chunk_delta` to a freshly
+     * generated `chunk`, restoring its edit set.
+     */
+    static auto apply_chunk_delta(std::span<const uint8_t> payload, Chunk& chunk) -> bool;
+
+private:
+    static auto get_entry_index(ChunkPosition pos) -> int;
+
+    // Platform specific, sets `file_size` on success.
+    auto open_file(const std::filesystem::path& path) -> bool;
+    void close_file();
+
+    // (Re)maps the file if it has grown past the current mapping.
+    auto ensure_mapped(size_t size) -> bool;
+    void unmap();
+
+    Entry entries[Size * Size] = {};
+    uint64_t file_size = 0;
+
+    const uint8_t* mapping = nullptr;
+    size_t mapped_size = 0;
+
+#ifdef _WIN32
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+enum class SaveMode : uint8_t {
+    // Every stored chunk is a full snapshot. Generated chunks are stored too,
+    // so revisits never re-run worldgen.
+    FULL,
+
+    // Only edits over the generated baseline are stored, chunks without edits
+    // are not stored at all. Loading regenerates the chunk and applies the
+    // edits. Chunks with too many edits are compacted into full snapshots.
+    DELTA
+};
+
+// Owns the open region files of a world directory and routes chunk reads and
+// writes to them.
+class RegionStorage {
+public:
+    struct Settings {
+        SaveMode save_mode = SaveMode::FULL;
+
+        // In delta mode, chunks with more edited voxels than this are saved
+        // as full snapshots from then on. Past a few thousand edits the
+        // delta is bigger than the RLE snapshot.
+        size_t compact_threshold = 4096;
+    };
+
+    RegionStorage(std::filesystem::path directory, Settings settings);
+    explicit RegionStorage(std::filesystem::path directory);
+
+    /**
+     * @brief Builds the payload to store for `chunk` according to the save
+     * mode. Marks the chunk as a snapshot when it is saved in full.
+     */
+    auto encode_for_save(Chunk& chunk) const -> std::vector<uint8_t>;
+
+    /**
+     * @brief Restores `chunk` from a stored payload of either kind,
+     * regenerating the baseline for delta payloads. `chunk.position` must be set.
+     */
+    static auto decode_payload(std::span<const uint8_t> payload, Chunk& chunk) -> bool;
+
+    /**
+     * @brief Forces `chunk` to be saved as a full snapshot from now on.
+     */
+    static void compact(Chunk& chunk);
+
+    auto load_chunk(Chunk& chunk) -> bool;
+    auto save_chunk(Chunk& chunk) -> bool;
+
+    /**
+     * @brief Retrieves the region file containing `pos`, opening or creating
+     * it as needed. Returns nullptr if the file can't be opened.
+     */
+    auto get_region(ChunkPosition pos) -> RegionFile*;
+
+    /**
+     * @brief Every region file opened so far. Files stay open, and the
+     * pointers valid, for the lifetime of the storage.
+     */
+    auto get_regions() const -> std::vector<RegionFile*>;
+
+    auto get_directory() const -> const std::filesystem::path& {
+        return directory;
+    }
+
+    Settings settings;
+
+private:
+    std::filesystem::path directory;
+    std::unordered_map<std::string, std::unique_ptr<RegionFile>> regions;
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef RL_SIMPLEX_BATCH_HPP
+#define RL_SIMPLEX_BATCH_HPP
+
+#include <noise_source.hpp>
+
+// Octave simplex noise evaluated for a whole grid of samples at once, with
+// the same lanes and the same bitwise guarantees as `PerlinBatch`. A 3D
+// sample touches 4 corners instead of Perlin's 8, and the gradients aren't
+// aligned to a cubic lattice, so there are no grid-aligned ridges.
+class SimplexBatch final : public NoiseSource {
+public:
+    explicit SimplexBatch(const siv::PerlinNoise& perlin);
+
+    void octave2D(std::span<float> out, int origin_x, int origin_z, int width, int depth,
+        float scale, int octaves, float persistence = 0.5f) const override;
+
+    void octave3D(std::span<float> out, int origin_x, int origin_y, int origin_z,
+        int width, int height, int depth, float scale, int octaves, float persistence = 0.5f) const override;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef RL_THREAD_POOL_HPP
+#define RL_THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <vector>
+
+// Fixed-size pool of worker threads running submitted tasks in FIFO order.
+// Tasks must not throw.
+class ThreadPool {
+public:
+    /**
+     * @brief Starts `thread_count` workers. 0 uses one worker per hardware
+     * thread, leaving one for the main thread.
+     */
+    explicit ThreadPool(unsigned int thread_count = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    auto get_thread_count() const -> unsigned int {
+        return static_cast<unsigned int>(workers.size());
+    }
+
+private:
+    void worker_loop(std::stop_token stop);
+
+    std::mutex mutex;
+    std::condition_variable_any condition;
+    std::deque<std::function<void()>> tasks;
+
+    // Declared last so workers are joined before the queue is destroyed.
+    std::vector<std::jthread> workers;
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef RL_VISIBILITY_HPP
+#define RL_VISIBILITY_HPP
+
+#include <voxel.hpp>
+
+#include <cstdint>
+
+// Which faces of a section can see each other through its air: two faces
+// are connected if some air pocket touches both. Used to walk from the
+// camera's section to the ones a line of sight can reach (see
+// `ChunkStreamer::get_visible_sections`), so caves and sealed terrain
+// behind solid rock aren't drawn.
+struct SectionConnectivity {
+    /**
+     * @brief Flood fills the air of `section` in `chunk`, starting from the
+     * voxels on its faces.
+     */
+    static auto compute(const Chunk& chunk, int section) -> SectionConnectivity;
+
+    auto connects(Chunk::Face a, Chunk::Face b) const -> bool {
+        return (bits >> (static_cast<int>(a) * Chunk::FaceCount + static_cast<int>(b))) & 1;
+    }
+
+    // Bit a * 6 + b for faces a and b, symmetric.
+    uint64_t bits = 0;
+};
+
+// Solid boxes under a chunk's surface, which hide whatever is behind them
+// (see `OcclusionCuller`). The chunk is split into groups of columns, each
+// with the range of y every one of its columns is solid in, going down from
+// its lowest surface. Only the top `MaxDepth` voxels are kept, the rest
+// mostly hides what the top already does and costs fill rate.
+struct ChunkOccluders {
+    static constexpr int GroupWidth = 4;
+    static constexpr int MaxDepth = 16;
+    static constexpr int GroupCount = Chunk::Width / GroupWidth;
+
+    static auto compute(const Chunk& chunk) -> ChunkOccluders;
+
+    // Solid from `bottom` up to `top`, nothing if `bottom` isn't below it.
+    int16_t bottom[GroupCount][GroupCount] = {};
+    int16_t top[GroupCount][GroupCount] = {};
+};
+
+#endif
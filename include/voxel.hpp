@@ -2,6 +2,8 @@
 #define RL_VOXEL_HPP
 
 #include <unordered_map>
+#include <unordered_set>
+#include <memory_stats.hpp>
 #include <iostream>
 #include <cstdint>
 
@@ -29,6 +31,11 @@ enum class VoxelType : uint8_t {
     GLASS
 };
 
+/**
+ * @brief Block light a voxel of `type` gives off, 0 for most types.
+ */
+auto get_light_emission(VoxelType type) -> uint8_t;
+
 struct UV {
     float u;
     float v;
@@ -162,7 +169,7 @@ struct ChunkPosition {
         }
     }
 
-    bool operator==(const ChunkPosition&& other) const {
+    bool operator==(const ChunkPosition& other) const {
         return x == other.x && y == other.y && z == other.z;
     }
 
@@ -178,13 +185,145 @@ struct Chunk {
     static constexpr int Width = 16;
     static constexpr int Height = 256;
 
+    // Chunks are summarised in 16-high sections for occupancy queries.
+    static constexpr int SectionHeight = 16;
+    static constexpr int SectionCount = Height / SectionHeight;
+    static constexpr int SectionVolume = Width * SectionHeight * Width;
+
+    // The six faces of a chunk or section, named by the axis direction they face.
+    enum class Face : uint8_t {
+        X_NEG,
+        X_POS,
+        Y_NEG,
+        Y_POS,
+        Z_NEG,
+        Z_POS
+    };
+    static constexpr int FaceCount = 6;
+
+    static constexpr uint8_t MaxLight = 15;
+
+    // 4-bit light levels (0 to `MaxLight`) of every voxel, two voxels per
+    // byte along z.
+    struct LightLevels {
+        auto get(int x, int y, int z) const -> uint8_t {
+            return (data[x][y][z / 2] >> ((z & 1) * 4)) & 0xF;
+        }
+
+        void set(int x, int y, int z, uint8_t level) {
+            auto& pair = data[x][y][z / 2];
+            const int shift = (z & 1) * 4;
+            pair = static_cast<uint8_t>((pair & ~(0xF << shift)) | (level << shift));
+        }
+
+        uint8_t data[Width][Height][Width / 2] = {};
+    };
+
     /**
      * @brief Populate this chunk to comprise entirely of the passed `type`.
      */
     void fill(VoxelType type);
 
+    /**
+     * @brief Edits a single voxel. Unlike writing `voxels` directly, this
+     * marks the chunk dirty and records the edit for delta saves. Worldgen
+     * writes `voxels` directly since its output is the baseline.
+     */
+    void set_voxel(int x, int y, int z, VoxelType type);
+
+    /**
+     * @brief `set_voxel` for worldgen: keeps the summaries up to date, but
+     * the voxel counts as generated rather than edited.
+     */
+    void set_generated_voxel(int x, int y, int z, VoxelType type);
+
+    /**
+     * @brief Index of a voxel in the flattened `voxels` array.
+     */
+    static constexpr auto get_voxel_index(int x, int y, int z) -> uint16_t {
+        return static_cast<uint16_t>((x * Height + y) * Width + z);
+    }
+
+    /**
+     * @brief Recomputes `heightmap` from scratch. Needed after writing
+     * `voxels` directly, `fill` and `set_voxel` keep it up to date.
+     */
+    void update_heightmap();
+
+    /**
+     * @brief Highest `heightmap` value in the x slice `x`, i.e. the y every
+     * voxel in that slice at or above is air.
+     */
+    auto get_slice_height(int x) const -> int;
+
+    /**
+     * @brief Recomputes the occupancy and emitter counts from scratch. Needed
+     * after writing `voxels` directly, `fill` and `set_voxel` keep them up to
+     * date.
+     */
+    void update_occupancy();
+
+    auto is_section_empty(int section) const -> bool {
+        return section_solid_count[section] == 0;
+    }
+
+    auto is_section_full(int section) const -> bool {
+        return section_solid_count[section] == SectionVolume;
+    }
+
+    /**
+     * @brief Whether every voxel on `face` of `section` is solid.
+     */
+    auto is_section_face_opaque(int section, Face face) const -> bool;
+
     Voxel voxels[Width][Height][Width] = {};
     ChunkPosition position = {};
+
+    // Light from the sky and from emitting voxels (see `compute_skylight`,
+    // `compute_blocklight`). Not saved, chunks are relit once loaded.
+    LightLevels skylight;
+    LightLevels blocklight;
+
+    // One past the highest non-air voxel of each column, 0 for columns that
+    // are all air. Indexed [x][z].
+    uint16_t heightmap[Width][Width] = {};
+
+    // Non-air voxels in the chunk, per section, and per section face
+    // (indexed by `Face`). Every non-air type counts as opaque.
+    uint32_t solid_count = 0;
+    uint16_t section_solid_count[SectionCount] = {};
+    uint16_t section_face_solid_count[SectionCount][FaceCount] = {};
+
+    // Voxels giving off light, so lighting can skip chunks without any.
+    uint32_t emitter_count = 0;
+
+    // Voxels edited since generation, by `get_voxel_index`. Only meaningful
+    // while `is_snapshot` is false. Its nodes count as voxel storage.
+    std::unordered_set<uint16_t, std::hash<uint16_t>, std::equal_to<uint16_t>,
+        MemoryAllocator<uint16_t, MemoryCategory::VOXEL_STORAGE>> edited_voxels;
+
+    // Set when the chunk has edits that haven't been saved yet.
+    bool dirty = false;
+
+    // Set once the chunk has been stored as a full snapshot. Its edits can no
+    // longer be told apart from the baseline, so it's always saved in full.
+    bool is_snapshot = false;
+
+    // Horizontal neighbours whose feature spill is in `voxels`, a bit each
+    // (see `get_spill_bit`). Saved with snapshots, so no spill is applied
+    // twice.
+    uint16_t spill_sources = 0;
+
+    [[no_unique_address]] MemoryTag<MemoryCategory::VOXEL_STORAGE, Chunk> memory_tag;
+
+private:
+    static constexpr auto get_face_area(Face face) -> uint16_t {
+        return (face == Face::Y_NEG || face == Face::Y_POS)
+            ? Width * Width : Width * SectionHeight;
+    }
+
+    // Adds `delta` (+1 or -1) solid voxels at (x, y, z) to the counts.
+    void add_occupancy(int x, int y, int z, int delta);
 };
 
 #endif 
\ No newline at end of file
@@ -4,20 +4,40 @@
 #include <voxel.hpp>
 
 #include <unordered_map>
+#include <memory>
 #include <string>
 
 struct World {
     /** 
-     * @brief World size in chunks.
+     * @brief World size in chunks. Only `y` bounds the world, chunks are
+     * streamed in along x/z (see `ChunkStreamer`).
      */
     struct WorldSize {
         int x = 64;
         int y = 1;
         int z = 64;
-    } world_size; // TODO: Crash during worldgen (not meshing) when x = 256
+    } world_size;
  
+    /**
+     * @brief Current version of the chunk at `pos`, or nullptr if it isn't
+     * loaded. Read-only for anyone but worldgen/loading; edits go through
+     * `get_writable_chunk()` or `set_voxel_at()`.
+     */
     auto get_chunk_at(ChunkPosition pos) -> Chunk*;
 
+    /**
+     * @brief Pins the current version of the chunk at `pos`. The pinned
+     * version never changes: edits made while it's pinned go to a copy.
+     * Pinning is meant for the main thread; the pin may be released anywhere.
+     */
+    auto pin_chunk(ChunkPosition pos) const -> std::shared_ptr<const Chunk>;
+
+    /**
+     * @brief Returns the chunk at `pos` for editing, replacing it with a
+     * private copy first if some version of it is pinned.
+     */
+    auto get_writable_chunk(ChunkPosition pos) -> Chunk*;
+
     /**
      * @brief Retrieve a reference to a voxel at the provided
      * `world_pos`. If the provided position falls out of the
@@ -26,7 +46,15 @@ struct World {
      */
     auto get_voxel_at(Position world_pos) const -> Voxel;
 
-    std::unordered_map<std::string, Chunk*> loaded_chunks;
+    /**
+     * @brief Edits the voxel at `world_pos` through `Chunk::set_voxel`.
+     * Returns false if the containing chunk isn't loaded.
+     */
+    auto set_voxel_at(Position world_pos, VoxelType type) -> bool;
+
+    // Chunks are shared with pinned readers (see `pin_chunk`), never
+    // modified while someone else holds them.
+    std::unordered_map<std::string, std::shared_ptr<Chunk>> loaded_chunks;
 
     auto get_chunk_key(ChunkPosition pos) const -> std::string;
 private:
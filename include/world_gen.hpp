@@ -0,0 +1,190 @@
+#ifndef RL_WORLD_GEN_HPP
+#define RL_WORLD_GEN_HPP
+
+#include <voxel.hpp>
+#include <noise_source.hpp>
+#include <noise_graph.hpp>
+#include <climate_map.hpp>
+#include <decoration.hpp>
+
+#include <memory>
+
+// 2D worldgen fields of one chunk column, i.e. everything that only depends on
+// (x, z). Shared by every chunk stacked on the column, see `ColumnCache`.
+struct ColumnFields {
+    // World y of the terrain surface, indexed [x][z].
+    int16_t heights[Chunk::Width][Chunk::Width];
+
+    // Decides the surface materials, indexed [x][z].
+    Biome biomes[Chunk::Width][Chunk::Width];
+};
+
+enum class TerrainMode : uint8_t {
+    // Solid below the surface height of each column.
+    HEIGHTMAP,
+
+    // Solid where a 3D density field is positive. The field is the distance
+    // below the surface height plus 3D noise, so the surface gets overhangs,
+    // and a second noise field carves caves.
+    DENSITY
+};
+
+// Procedural terrain generation. A generator's output is a pure function of
+// its settings and the chunk position, so a chunk can be thrown away and
+// regenerated at any time with identical results. That includes features
+// crossing into neighbouring chunks: what a chunk spills is a function of
+// its position as well, see `get_spill`. All of its state is
+// read-only after construction apart from the climate cache, which is
+// thread-safe, so any number of threads may generate chunks with one
+// generator at once, in any order.
+class WorldGenerator {
+public:
+    struct Settings {
+        // 123456 is my favorite seed
+        unsigned int seed = 123456u;
+
+        float inv_scale = 0.0007f;
+        int min_height = 100;
+        int octaves = 8;
+
+        TerrainMode mode = TerrainMode::DENSITY;
+
+        // Noise behind every field. Delta saves are stored against the
+        // default generator, so changing its backend invalidates them.
+        NoiseBackend backend = NoiseBackend::PERLIN;
+
+        // Density noise. `squash` is how many voxels the surface moves per
+        // unit of noise.
+        float density_scale = 0.015f;
+        int density_octaves = 3;
+        float squash = 24.0f;
+
+        // Caves are carved where the cave noise is within `cave_width` of 0,
+        // which gives long winding tunnels.
+        float cave_scale = 0.025f;
+        int cave_octaves = 2;
+        float cave_width = 0.03f;
+
+        // Climate noise for biomes, see `ClimateMap`.
+        float climate_scale = 0.0012f;
+        int climate_octaves = 2;
+
+        // Ore veins per chunk. Boulders depend on the biome.
+        int coal_veins = 12;
+        int iron_veins = 6;
+        int gold_veins = 2;
+    };
+
+    // Density noise is sampled every `DensityStep` voxels along each axis and
+    // trilinearly interpolated in between. Must divide the chunk size.
+    static constexpr int DensityStep = 4;
+
+    explicit WorldGenerator(Settings settings);
+    WorldGenerator();
+
+    // The height graph points into the generator's own noise.
+    WorldGenerator(const WorldGenerator&) = delete;
+    WorldGenerator& operator=(const WorldGenerator&) = delete;
+
+    /**
+     * @brief Retrieves the terrain surface height of the column at local
+     * coordinates (`x`, `z`) within `chunk`. In `TerrainMode::DENSITY` that's
+     * the height the density field is centered on, the actual surface may
+     * be a few voxels off.
+     */
+    auto get_height(const Chunk& chunk, int x, int z) const -> int;
+
+    /**
+     * @brief Computes the 2D fields of the column containing `pos`. Only x
+     * and z of `pos` are used.
+     */
+    void get_column_fields(ChunkPosition pos, ColumnFields& fields) const;
+
+    /**
+     * @brief Fills an empty chunk with terrain. `chunk.position` must be set
+     * beforehand.
+     */
+    void populate(Chunk& chunk) const;
+
+    /**
+     * @brief Same as `populate(chunk)`, with the column's fields already
+     * computed by `get_column_fields`.
+     */
+    void populate(Chunk& chunk, const ColumnFields& fields) const;
+
+    /**
+     * @brief First half of `populate`: solid terrain and caves, all stone.
+     * The chunk's heightmap and occupancy are left for `populate_surface`.
+     */
+    void populate_terrain(Chunk& chunk, const ColumnFields& fields) const;
+
+    /**
+     * @brief Second half of `populate`: biome materials on top of the
+     * terrain, then the chunk's heightmap and occupancy.
+     */
+    void populate_surface(Chunk& chunk, const ColumnFields& fields) const;
+
+    /**
+     * @brief Places the features (ore veins, boulders) starting in a
+     * populated chunk. Voxels that land in the chunk are written as part of
+     * its terrain; voxels that land in a horizontal neighbour are added to
+     * `spill`, to be queued for it (see `DecorationQueue`). Features never
+     * cross the top or bottom of a chunk.
+     */
+    void decorate(Chunk& chunk, const ColumnFields& fields, std::vector<FeatureSpill>& spill) const;
+
+    /**
+     * @brief Adds the same spill `decorate` gives for the chunk at `pos` to
+     * `spill`, without populating it. Only ore veins cross chunk borders,
+     * and they don't depend on the terrain, so this is a few hundred random
+     * numbers.
+     */
+    void get_spill(ChunkPosition pos, std::vector<FeatureSpill>& spill) const;
+
+    auto get_settings() const -> const Settings& {
+        return settings;
+    }
+
+private:
+    // Relief above `min_height`: |noise| * `Chunk::Height`, as a V-shaped
+    // spline. Biomes scale and offset it, see `get_surface_height`.
+    using HeightGraph = Noise::Spline<Noise::Octaves, 3>;
+
+    auto make_height_graph() const -> HeightGraph;
+    auto get_surface_height(float relief, const ColumnBiome& biome) const -> int;
+
+    void terrain_heightmap(Chunk& chunk, const ColumnFields& fields) const;
+    void surface_heightmap(Chunk& chunk, const ColumnFields& fields) const;
+    void terrain_density(Chunk& chunk, const ColumnFields& fields) const;
+    void surface_density(Chunk& chunk, const ColumnFields& fields) const;
+
+    Settings settings;
+    std::unique_ptr<NoiseSource> noise;
+    std::unique_ptr<NoiseSource> density_noise;
+    std::unique_ptr<NoiseSource> cave_noise;
+    std::unique_ptr<NoiseSource> temperature_noise;
+    std::unique_ptr<NoiseSource> humidity_noise;
+
+    HeightGraph height_graph;
+    ClimateMap climate;
+};
+
+/**
+ * @brief The generator with default settings. Delta saves are stored
+ * against its output.
+ */
+auto get_default_generator() -> const WorldGenerator&;
+
+/**
+ * @brief `get_height` of the default generator.
+ */
+int get_voxel_height(const Chunk& chunk, int x, int z);
+
+/**
+ * @brief `populate` and `decorate` of the default generator, plus what every
+ * neighbour spills into the chunk. That's the baseline delta saves are
+ * stored against.
+ */
+void populate_chunk(Chunk& chunk);
+
+#endif
@@ -5,15 +5,24 @@ out vec4 FragColor;
 in vec3 FragPos;
 in vec2 TexCoord;
 in vec3 Normal;
+in vec2 Light;
 
 uniform vec3 u_lightpos;
 uniform vec3 u_camerapos;
 
+// How bright the sky is at this time of day, 0 to 1.
+uniform float u_sky_brightness;
+
 uniform sampler2D map;
 
 void main() {
     vec3 normal = normalize(Normal);
     FragColor = texture(map, TexCoord) - 0.05 - (0.075 * (1 - normal.y)) + (0.05 * (1 - abs(normal.z))) - (0.05 * -normal.y);
+
+    // Each light level is 80% as bright as the one above it, with a floor so
+    // caves aren't pitch black. Block light doesn't care about the time.
+    float light = max(Light.x * u_sky_brightness, Light.y);
+    FragColor.rgb *= max(pow(0.8, 15.0 * (1.0 - light)), 0.05);
     //FragColor = vec4(0.85, 0.85, 0.85, 1.0) - 0.05 - (0.075 * (1 - normal.y)) + (0.05 * (1 - abs(normal.z))) - (0.05 * -normal.y);
 
     vec3 fogColor = vec3(0.52, 0.71, 0.83);
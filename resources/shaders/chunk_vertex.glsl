@@ -3,6 +3,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTex;
 layout (location = 2) in vec3 aNormal;
+layout (location = 3) in float aLight;
 
 uniform mat4 u_transform;
 uniform mat4 u_model;
@@ -10,10 +11,13 @@ uniform mat4 u_model;
 out vec2 TexCoord;
 out vec3 Normal;
 out vec3 FragPos;
+// Sky and block light, 0 to 1.
+out vec2 Light;
 
 void main() {
     gl_Position = u_transform * u_model * vec4(aPos, 1.0);
     TexCoord = aTex;
     Normal = aNormal;
     FragPos = u_model[3].xyz + aPos;
+    Light = vec2(floor(aLight / 16.0), mod(aLight, 16.0)) / 15.0;
 }
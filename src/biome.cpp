@@ -0,0 +1,25 @@
+#include <biome.hpp>
+
+namespace {
+    // Indexed by `Biome`.
+    const BiomeInfo biome_infos[] = {
+        { "plains", VoxelType::GRASS, VoxelType::DIRT, 2, 0.0f, 1.0f, 0.2f },
+        { "desert", VoxelType::SAND, VoxelType::SAND, 4, -4.0f, 0.4f, 0.1f },
+        { "highlands", VoxelType::ROCKS, VoxelType::STONE, 1, 12.0f, 1.4f, 1.5f },
+        { "wastes", VoxelType::STONE, VoxelType::STONE, 0, 4.0f, 0.7f, 0.5f },
+    };
+}
+
+auto classify_biome(float temperature, float humidity) -> Biome {
+    if (temperature < -0.15f) {
+        return Biome::HIGHLANDS;
+    }
+    if (temperature > 0.15f) {
+        return (humidity < 0.0f) ? Biome::DESERT : Biome::WASTES;
+    }
+    return Biome::PLAINS;
+}
+
+auto get_biome_info(Biome biome) -> const BiomeInfo& {
+    return biome_infos[static_cast<int>(biome)];
+}
@@ -0,0 +1,329 @@
+#include <chunk_io.hpp>
+
+#include <algorithm>
+#include <ostream>
+#include <utility>
+#include <thread>
+#include <cstring>
+#include <bit>
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    auto us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+    int bucket = (us == 0) ? 0 : std::bit_width(us) - 1;
+    if (bucket >= BucketCount) bucket = BucketCount - 1;
+
+    ++buckets[bucket];
+    ++count;
+}
+
+uint64_t LatencyHistogram::get_percentile(double p) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<uint64_t>(p * static_cast<double>(count));
+    uint64_t seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen > target || seen == count) {
+            return uint64_t{ 1 } << (i + 1);
+        }
+    }
+
+    return uint64_t{ 1 } << BucketCount;
+}
+
+ChunkIO::ChunkIO(RegionStorage& storage, Settings settings) : storage{storage} {
+    backend = settings.force_thread_pool
+        ? create_thread_pool_io_backend(settings.queue_depth)
+        : create_io_backend(settings.queue_depth);
+}
+
+ChunkIO::ChunkIO(RegionStorage& storage) : ChunkIO(storage, Settings{}) {}
+
+ChunkIO::~ChunkIO() {
+    // Buffers and region files must outlive the backend's use of them.
+    wait_idle();
+}
+
+void ChunkIO::request_load(ChunkPosition pos) {
+    auto saving = pending_saves.find(get_key(pos));
+    if (saving != pending_saves.end()) {
+        completions.push_back({ Completion::Type::LOAD, pos, true, *saving->second.payload });
+        return;
+    }
+
+    auto* file = storage.get_region(pos);
+    if (!file || !file->has_chunk(pos)) {
+        completions.push_back({ Completion::Type::LOAD, pos, false, {} });
+        return;
+    }
+
+    auto entry = file->get_entry(pos);
+    auto id = next_id++;
+    auto& request = requests[id];
+    request.stage = Request::Stage::READ_PAYLOAD;
+    request.position = pos;
+    request.file = file;
+    request.entry = entry;
+    request.buffer.resize(entry.length);
+    request.buffer_memory.reset(static_cast<int64_t>(request.buffer.capacity()));
+    request.start = std::chrono::steady_clock::now();
+
+    queued.push_back(id);
+}
+
+void ChunkIO::request_save(ChunkPosition pos, std::vector<uint8_t> payload) {
+    auto* file = storage.get_region(pos);
+    uint64_t offset = file ? file->reserve(static_cast<uint32_t>(payload.size())) : 0;
+    if (offset == 0) {
+        ++stats.failures;
+        completions.push_back({ Completion::Type::SAVE, pos, false, {} });
+        return;
+    }
+
+    auto sequence = next_save_sequence++;
+    auto shared = std::make_shared<std::vector<uint8_t>>(std::move(payload));
+    pending_saves[get_key(pos)] = { sequence, shared };
+
+    auto id = next_id++;
+    auto& request = requests[id];
+    request.stage = Request::Stage::WRITE_PAYLOAD;
+    request.position = pos;
+    request.file = file;
+    request.entry = { static_cast<uint32_t>(offset), static_cast<uint32_t>(shared->size()) };
+    request.buffer_memory.reset(static_cast<int64_t>(shared->capacity()));
+    request.payload = std::move(shared);
+    request.save_sequence = sequence;
+    request.start = std::chrono::steady_clock::now();
+
+    queued.push_back(id);
+}
+
+std::vector<ChunkIO::Completion> ChunkIO::poll() {
+    std::vector<IoResult> results;
+    backend->poll(results);
+    in_flight -= static_cast<unsigned int>(results.size());
+
+    for (const auto& result : results) {
+        handle_result(result);
+    }
+
+    submit_queued();
+
+    return std::exchange(completions, {});
+}
+
+void ChunkIO::wait_idle() {
+    while (!requests.empty()) {
+        std::vector<IoResult> results;
+        backend->poll(results);
+        in_flight -= static_cast<unsigned int>(results.size());
+
+        for (const auto& result : results) {
+            handle_result(result);
+        }
+
+        submit_queued();
+
+        if (results.empty()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool ChunkIO::is_saved_through(uint64_t sequence) const {
+    for (const auto& [id, request] : requests) {
+        if (request.save_sequence != 0 && request.save_sequence <= sequence) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChunkIO::print_stats(std::ostream& out) const {
+    out << "Chunk I/O (" << get_backend_name() << "): "
+        << stats.loads << " loads (p50 " << stats.load_latency.get_percentile(0.5)
+        << "us, p99 " << stats.load_latency.get_percentile(0.99) << "us), "
+        << stats.saves << " saves (p50 " << stats.save_latency.get_percentile(0.5)
+        << "us, p99 " << stats.save_latency.get_percentile(0.99) << "us), "
+        << stats.failures << " failures\n";
+}
+
+void ChunkIO::submit_queued() {
+    std::vector<IoOp> ops;
+
+    const unsigned int depth = backend->get_queue_depth();
+    while (!queued.empty() && in_flight < depth) {
+        auto id = queued.front();
+        queued.pop_front();
+
+        auto& request = requests.at(id);
+        IoOp op = {};
+        op.file = request.file;
+        op.user_data = id;
+        op.buffer = request.buffer.data();
+        op.length = static_cast<uint32_t>(request.buffer.size());
+
+        switch (request.stage) {
+        case Request::Stage::READ_PAYLOAD:
+            op.type = IoOp::Type::READ;
+            op.offset = request.entry.offset;
+            break;
+        case Request::Stage::WRITE_PAYLOAD:
+            op.type = IoOp::Type::WRITE;
+            op.offset = request.entry.offset;
+            op.buffer = request.payload->data();
+            op.length = static_cast<uint32_t>(request.payload->size());
+            break;
+        case Request::Stage::WRITE_HEADER:
+            op.type = IoOp::Type::WRITE;
+            op.offset = RegionFile::get_entry_file_offset(request.position);
+            break;
+        }
+
+        ops.push_back(op);
+        ++in_flight;
+    }
+
+    if (!ops.empty()) {
+        backend->submit(ops);
+    }
+}
+
+void ChunkIO::handle_result(const IoResult& result) {
+    switch (requests.at(result.user_data).stage) {
+    case Request::Stage::READ_PAYLOAD:
+        finish(result.user_data, result.success);
+        break;
+    case Request::Stage::WRITE_PAYLOAD:
+        finish_payload(result.user_data, result.success);
+        break;
+    case Request::Stage::WRITE_HEADER:
+        finish_header(result.user_data, result.success);
+        break;
+    }
+}
+
+void ChunkIO::finish_payload(uint64_t id, bool success) {
+    auto& request = requests.at(id);
+    auto key = get_key(request.position);
+
+    // An older save that finishes after a newer one must not repoint the
+    // entry back to stale data.
+    auto pending = pending_saves.find(key);
+    const bool latest = pending != pending_saves.end() && pending->second.sequence == request.save_sequence;
+
+    if (!success) {
+        finish(id, false);
+
+        // Older saves waiting for this one to be published never get a
+        // header, fail them so their chunks get saved again.
+        auto state = headers.find(key);
+        if (latest && state != headers.end()) {
+            const auto published = state->second.published;
+            std::erase_if(state->second.waiting, [&](uint64_t waiting) {
+                if (requests.at(waiting).save_sequence <= published) {
+                    return false;
+                }
+                finish(waiting, false);
+                return true;
+            });
+
+            if (!state->second.writing && state->second.waiting.empty()) {
+                headers.erase(state);
+            }
+        }
+        return;
+    }
+
+    // Superseded by a save that has finished already.
+    if (pending == pending_saves.end()) {
+        finish(id, true);
+        return;
+    }
+
+    // The payload is on disk, publish it.
+    auto& state = headers[key];
+    if (latest) {
+        request.file->set_entry(request.position, request.entry);
+        state.published = request.save_sequence;
+    }
+
+    state.waiting.push_back(id);
+    write_header(state);
+}
+
+void ChunkIO::finish_header(uint64_t id, bool success) {
+    const auto sequence = requests.at(id).save_sequence;
+    auto key = get_key(requests.at(id).position);
+    auto state = headers.find(key);
+    state->second.writing = false;
+
+    // Every save up to this one is covered by the header now on disk. A
+    // failed write marks them failed, so their chunks get saved again.
+    std::erase_if(state->second.waiting, [&](uint64_t waiting) {
+        if (requests.at(waiting).save_sequence > sequence) {
+            return false;
+        }
+        finish(waiting, success);
+        return true;
+    });
+
+    write_header(state->second);
+    if (!state->second.writing && state->second.waiting.empty()) {
+        headers.erase(state);
+    }
+}
+
+void ChunkIO::write_header(HeaderState& state) {
+    if (state.writing || state.published <= state.written) {
+        return;
+    }
+
+    // The save that published the entry writes it, it waits for exactly
+    // this header.
+    auto carrier = std::find_if(state.waiting.begin(), state.waiting.end(), [&](uint64_t waiting) {
+        return requests.at(waiting).save_sequence == state.published;
+    });
+    auto& request = requests.at(*carrier);
+
+    request.stage = Request::Stage::WRITE_HEADER;
+    request.buffer.resize(sizeof (RegionFile::Entry));
+    std::memcpy(request.buffer.data(), &request.entry, sizeof (RegionFile::Entry));
+
+    state.written = state.published;
+    state.writing = true;
+    queued.push_back(*carrier);
+}
+
+void ChunkIO::finish(uint64_t id, bool success) {
+    auto it = requests.find(id);
+    auto& request = it->second;
+    auto latency = std::chrono::steady_clock::now() - request.start;
+
+    if (!success) {
+        ++stats.failures;
+    }
+
+    if (request.stage == Request::Stage::READ_PAYLOAD) {
+        ++stats.loads;
+        stats.load_latency.record(latency);
+        completions.push_back({ Completion::Type::LOAD, request.position, success, std::move(request.buffer) });
+    } else {
+        ++stats.saves;
+        stats.save_latency.record(latency);
+        completions.push_back({ Completion::Type::SAVE, request.position, success, {} });
+
+        auto pending = pending_saves.find(get_key(request.position));
+        if (pending != pending_saves.end() && pending->second.sequence == request.save_sequence) {
+            pending_saves.erase(pending);
+        }
+    }
+
+    requests.erase(it);
+}
+
+std::string ChunkIO::get_key(ChunkPosition pos) {
+    return std::to_string(pos.x) + "_" + std::to_string(pos.y) + "_" + std::to_string(pos.z);
+}
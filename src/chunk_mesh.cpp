@@ -1,18 +1,54 @@
 #include <voxel.hpp>
 #include <chunk_mesh.hpp>
 
-// texture rotation stuff lol
+#include <algorithm>
+
+namespace {
+    // Stand-in for missing neighbours, open to the sky. Initialised once,
+    // safe across mesh jobs.
+    const Chunk* get_empty_chunk() {
+        static const Chunk* empty_chunk = [] {
+            auto* chunk = new Chunk{};
+            std::fill_n(&chunk->skylight.data[0][0][0], sizeof chunk->skylight.data, 0xFF);
+            return chunk;
+        }();
+        return empty_chunk;
+    }
+
+    // Texture variation noise. Shared, so mesh jobs don't each seed their own.
+    const NoiseSource* get_texture_noise() {
+        static const auto texture_noise = make_noise_source(NoiseBackend::PERLIN, 123456u);
+        return texture_noise.get();
+    }
+}
+
+ChunkSnapshot ChunkSnapshot::pin(const World& world, ChunkPosition pos) {
+    return {
+        world.pin_chunk(pos),
+        world.pin_chunk(pos + ChunkPosition{ -1, 0, 0 }),
+        world.pin_chunk(pos + ChunkPosition{ 1, 0, 0 }),
+        world.pin_chunk(pos + ChunkPosition{ 0, -1, 0 }),
+        world.pin_chunk(pos + ChunkPosition{ 0, 1, 0 }),
+        world.pin_chunk(pos + ChunkPosition{ 0, 0, -1 }),
+        world.pin_chunk(pos + ChunkPosition{ 0, 0, 1 })
+    };
+}
 
-#include <siv/PerlinNoise.hpp>
+ChunkMesher::ChunkMesher(const ChunkSnapshot& snapshot, const UVOffsetScheme* s)
+    : chunk{snapshot.chunk.get()}, uv_scheme{s}, texture_noise{ get_texture_noise() } {
+    const Chunk* empty_chunk = get_empty_chunk();
 
-// end texture rotation stuff 
+    cache_chunk_x_left = snapshot.x_left ? snapshot.x_left.get() : empty_chunk;
+    cache_chunk_x_right = snapshot.x_right ? snapshot.x_right.get() : empty_chunk;
+    cache_chunk_y_bottom = snapshot.y_bottom ? snapshot.y_bottom.get() : empty_chunk;
+    cache_chunk_y_top = snapshot.y_top ? snapshot.y_top.get() : empty_chunk;
+    cache_chunk_z_back = snapshot.z_back ? snapshot.z_back.get() : empty_chunk;
+    cache_chunk_z_front = snapshot.z_front ? snapshot.z_front.get() : empty_chunk;
+}
 
 ChunkMesher::ChunkMesher(const Chunk* chunk, World* world, UVOffsetScheme* s) 
-    : chunk{chunk}, world{world}, uv_scheme{s} {
-    static Chunk* empty_chunk = nullptr;
-    if (!empty_chunk) {
-        empty_chunk = new Chunk{};
-    }
+    : chunk{chunk}, world{world}, uv_scheme{s}, texture_noise{ get_texture_noise() } {
+    const Chunk* empty_chunk = get_empty_chunk();
 
     if (world) {
         cache_chunk_z_front = world->get_chunk_at(chunk->position + ChunkPosition{ 0, 0, 1 });
@@ -44,58 +80,98 @@ void ChunkMesh::upload_buffers() {
 
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof vertices[0], vertices.data(), GL_STATIC_DRAW);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof indices[0], indices.data(), GL_STATIC_DRAW);
+    gpu_memory.reset(static_cast<int64_t>(vertices.size() * sizeof (Vertex) + indices.size() * sizeof (GLuint)));
 
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof (Vertex), (void*)0);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof (Vertex), (void*)(3 * sizeof (float)));
     glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof (Vertex), (void*)(5 * sizeof (float)));
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof (Vertex), (void*)(8 * sizeof (float)));
 
     glEnableVertexAttribArray(0);
     glEnableVertexAttribArray(1);
     glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(3);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
 
+void ChunkMesh::destroy_buffers() {
+    if (vao != 0) {
+        glDeleteVertexArrays(1, &vao);
+        glDeleteBuffers(1, &vbo);
+        glDeleteBuffers(1, &ebo);
+    }
+
+    vao = 0;
+    vbo = 0;
+    ebo = 0;
+    gpu_memory.reset();
+}
+
+void ChunkMesh::account_cpu_memory() {
+    const auto used = vertices.size() * sizeof (Vertex) + indices.size() * sizeof (GLuint);
+    const auto reserved = vertices.capacity() * sizeof (Vertex) + indices.capacity() * sizeof (GLuint);
+
+    cpu_memory.reset(static_cast<int64_t>(used));
+    cpu_overhead.reset(static_cast<int64_t>(reserved - used));
+}
+
+void ChunkMesh::release_cpu_memory() {
+    vertices = {};
+    indices = {};
+    cpu_memory.reset();
+    cpu_overhead.reset();
+}
+
 ChunkMesh ChunkMesher::generate_mesh()  {
     auto mesh = ChunkMesh{};
 
-    // 1. iterate all internal voxels (minimize bounds checking)
-    for (int x = 1; x < Chunk::Width - 1; ++x) {
-        for (int y = 1; y < Chunk::Height - 1; ++y) {
-            for (int z = 1; z < Chunk::Width - 1; ++z) {
-                if (chunk->voxels[x][y][z].type != VoxelType::NONE) add_non_edge_voxel(mesh, x, y, z);
-            }
-        }
+    // Everything at or above a slice's height is air and adds no faces, so
+    // the y loops stop there.
+    int y_end[Chunk::Width];
+    for (int x = 0; x < Chunk::Width; ++x) {
+        y_end[x] = chunk->get_slice_height(x);
     }
 
-    // 2. iterate all edge voxels (bounds checking performed with neighboring chunks)
-    for (int x = 0; x < Chunk::Width; ++x) {
-        for (int y = 1; y < Chunk::Height-1; ++y) {
-            if (x == 0 || x == Chunk::Width-1) {
-                for (int z = 1; z < Chunk::Width-1; ++z) {
-                    if (chunk->voxels[x][y][z].type != VoxelType::NONE) add_voxel(mesh, x, y, z);
+    // 1. iterate section by section. Empty sections add nothing, and buried
+    // ones only add faces that are hidden anyway.
+    for (int section = 0; section < Chunk::SectionCount; ++section) {
+        // Six indices per four vertices, see below.
+        mesh.section_offsets[section] = static_cast<uint32_t>(mesh.vertices.size() / 4 * 6);
+        mesh.section_connectivity[section] = SectionConnectivity::compute(*chunk, section);
+
+        if (chunk->is_section_empty(section) || is_section_buried(section)) continue;
+
+        const int y_begin = section * Chunk::SectionHeight;
+        for (int x = 0; x < Chunk::Width; ++x) {
+            const int y_stop = std::min(y_begin + Chunk::SectionHeight, y_end[x]);
+            const bool x_edge = (x == 0 || x == Chunk::Width - 1);
+
+            for (int y = y_begin; y < y_stop; ++y) {
+                // 2. edge voxels (bounds checking performed with neighboring chunks)
+                if (x_edge || y == 0 || y == Chunk::Height - 1) {
+                    for (int z = 0; z < Chunk::Width; ++z) {
+                        if (chunk->voxels[x][y][z].type != VoxelType::NONE) add_voxel(mesh, x, y, z);
+                    }
+                    continue;
                 }
-            }
 
-            int z1 = 0;
-            int z2 = Chunk::Width-1;
+                int z1 = 0;
+                int z2 = Chunk::Width-1;
 
-            if (chunk->voxels[x][y][z1].type != VoxelType::NONE) add_voxel(mesh, x, y, z1);
-            if (chunk->voxels[x][y][z2].type != VoxelType::NONE) add_voxel(mesh, x, y, z2);
+                if (chunk->voxels[x][y][z1].type != VoxelType::NONE) add_voxel(mesh, x, y, z1);
+                for (int z = 1; z < Chunk::Width - 1; ++z) {
+                    if (chunk->voxels[x][y][z].type != VoxelType::NONE) add_non_edge_voxel(mesh, x, y, z);
+                }
+                if (chunk->voxels[x][y][z2].type != VoxelType::NONE) add_voxel(mesh, x, y, z2);
+            }
         }
     }
 
-    for (int x = 0; x < Chunk::Width; ++x) {
-        for (int z = 0; z < Chunk::Width; ++z) {
-            int y1 = 0;
-            int y2 = Chunk::Height-1;
-
-            if (chunk->voxels[x][y1][z].type != VoxelType::NONE) add_voxel(mesh, x, y1, z);
-            if (chunk->voxels[x][y2][z].type != VoxelType::NONE) add_voxel(mesh, x, y2, z);
-        }
-    }
+    mesh.section_offsets[Chunk::SectionCount] = static_cast<uint32_t>(mesh.vertices.size() / 4 * 6);
+    mesh.occluders = ChunkOccluders::compute(*chunk);
 
     // 3. add indices (changing this can change draw direction, btw)
     for (unsigned int i = 0; i < static_cast<unsigned int>(mesh.vertices.size()); i += 4) {
@@ -104,9 +180,58 @@ ChunkMesh ChunkMesher::generate_mesh()  {
         });
     }
 
+    mesh.account_cpu_memory();
+
     return mesh;
 }
 
+bool ChunkMesher::is_section_buried(int section) const {
+    using Face = Chunk::Face;
+
+    if (!chunk->is_section_full(section)) {
+        return false;
+    }
+
+    const bool below = (section > 0)
+        ? chunk->is_section_face_opaque(section - 1, Face::Y_POS)
+        : cache_chunk_y_bottom->is_section_face_opaque(Chunk::SectionCount - 1, Face::Y_POS);
+    const bool above = (section < Chunk::SectionCount - 1)
+        ? chunk->is_section_face_opaque(section + 1, Face::Y_NEG)
+        : cache_chunk_y_top->is_section_face_opaque(0, Face::Y_NEG);
+
+    return below && above
+        && cache_chunk_x_left->is_section_face_opaque(section, Face::X_POS)
+        && cache_chunk_x_right->is_section_face_opaque(section, Face::X_NEG)
+        && cache_chunk_z_back->is_section_face_opaque(section, Face::Z_POS)
+        && cache_chunk_z_front->is_section_face_opaque(section, Face::Z_NEG);
+}
+
+float ChunkMesher::get_face_light(int x, int y, int z) const {
+    const Chunk* source = chunk;
+    if (x < 0) {
+        source = cache_chunk_x_left;
+        x += Chunk::Width;
+    } else if (x >= Chunk::Width) {
+        source = cache_chunk_x_right;
+        x -= Chunk::Width;
+    } else if (y < 0) {
+        source = cache_chunk_y_bottom;
+        y += Chunk::Height;
+    } else if (y >= Chunk::Height) {
+        source = cache_chunk_y_top;
+        y -= Chunk::Height;
+    } else if (z < 0) {
+        source = cache_chunk_z_back;
+        z += Chunk::Width;
+    } else if (z >= Chunk::Width) {
+        source = cache_chunk_z_front;
+        z -= Chunk::Width;
+    }
+
+    // Small integers, exact as floats.
+    return static_cast<float>(source->skylight.get(x, y, z) * 16 + source->blocklight.get(x, y, z));
+}
+
 void ChunkMesher::add_voxel(ChunkMesh& mesh, int x, int y, int z) {
     VoxelType front = (z == Chunk::Width-1) 
         ? cache_chunk_z_front->voxels[x][y][0].type : chunk->voxels[x][y][z+1].type;
@@ -136,7 +261,8 @@ void ChunkMesher::add_voxel(ChunkMesh& mesh, int x, int y, int z) {
     // if (chunk->voxels[x][y][z].type == VoxelType::GRASS) {
     //     UVQuad rot = uv.top;
 
-    //     double noise = perlin.noise2D(((double)x + chunk->position.x * Chunk::Width) * 0.4, ((double)z + chunk->position.z * Chunk::Width) * 0.4);
+    //     float noise;
+    //     texture_noise->octave2D({ &noise, 1 }, x + chunk->position.x * Chunk::Width, z + chunk->position.z * Chunk::Width, 1, 1, 0.4f, 1);
     //     if (noise > 0.03) {
     //         rot = {
     //             uv.top.bottom_right,
@@ -166,51 +292,57 @@ void ChunkMesher::add_voxel(ChunkMesh& mesh, int x, int y, int z) {
     
 
     if (front == VoxelType::NONE) {
+        const float light = get_face_light(x, y, z + 1);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf, yf, zf,       uv.front.top_right.u, uv.front.top_right.v, 0, 0, 1 },
-            { xf, yf-1, zf,     uv.front.bottom_right.u, uv.front.bottom_right.v, 0, 0, 1 },
-            { xf-1, yf-1, zf,   uv.front.bottom_left.u, uv.front.bottom_left.v, 0, 0, 1 },
-            { xf-1, yf, zf,     uv.front.top_left.u, uv.front.top_left.v, 0, 0, 1 }
+            { xf, yf, zf,       uv.front.top_right.u, uv.front.top_right.v, 0, 0, 1, light },
+            { xf, yf-1, zf,     uv.front.bottom_right.u, uv.front.bottom_right.v, 0, 0, 1, light },
+            { xf-1, yf-1, zf,   uv.front.bottom_left.u, uv.front.bottom_left.v, 0, 0, 1, light },
+            { xf-1, yf, zf,     uv.front.top_left.u, uv.front.top_left.v, 0, 0, 1, light }
         });
     }
     if (back == VoxelType::NONE) {
+        const float light = get_face_light(x, y, z - 1);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf-1, yf, zf-1,   uv.back.top_right.u, uv.back.top_right.v, 0, 0, -1 },
-            { xf-1, yf-1, zf-1, uv.back.bottom_right.u, uv.back.bottom_right.v, 0, 0, -1 },
-            { xf, yf-1, zf-1,   uv.back.bottom_left.u, uv.back.bottom_left.v, 0, 0, -1 },
-            { xf, yf, zf-1,     uv.back.top_left.u, uv.back.top_left.v, 0, 0, -1 },
+            { xf-1, yf, zf-1,   uv.back.top_right.u, uv.back.top_right.v, 0, 0, -1, light },
+            { xf-1, yf-1, zf-1, uv.back.bottom_right.u, uv.back.bottom_right.v, 0, 0, -1, light },
+            { xf, yf-1, zf-1,   uv.back.bottom_left.u, uv.back.bottom_left.v, 0, 0, -1, light },
+            { xf, yf, zf-1,     uv.back.top_left.u, uv.back.top_left.v, 0, 0, -1, light },
         });
     }
     if (right == VoxelType::NONE) {
+        const float light = get_face_light(x + 1, y, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf, yf, zf-1,     uv.right.top_right.u, uv.right.top_right.v, 1, 0, 0 },
-            { xf, yf-1, zf-1,   uv.right.bottom_right.u, uv.right.bottom_right.v, 1, 0, 0 },
-            { xf, yf-1, zf,     uv.right.bottom_left.u, uv.right.bottom_left.v, 1, 0, 0 },
-            { xf, yf, zf,       uv.right.top_left.u, uv.right.top_left.v, 1, 0, 0 },
+            { xf, yf, zf-1,     uv.right.top_right.u, uv.right.top_right.v, 1, 0, 0, light },
+            { xf, yf-1, zf-1,   uv.right.bottom_right.u, uv.right.bottom_right.v, 1, 0, 0, light },
+            { xf, yf-1, zf,     uv.right.bottom_left.u, uv.right.bottom_left.v, 1, 0, 0, light },
+            { xf, yf, zf,       uv.right.top_left.u, uv.right.top_left.v, 1, 0, 0, light },
         });
     }
     if (left == VoxelType::NONE) {
+        const float light = get_face_light(x - 1, y, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf-1, yf, zf,     uv.left.top_right.u, uv.left.top_right.v, -1, 0, 0 },
-            { xf-1, yf-1, zf,   uv.left.bottom_right.u, uv.left.bottom_right.v, -1, 0, 0 },
-            { xf-1, yf-1, zf-1, uv.left.bottom_left.u, uv.left.bottom_left.v, -1, 0, 0 },
-            { xf-1, yf, zf-1,   uv.left.top_left.u, uv.left.top_left.v, -1, 0, 0 },
+            { xf-1, yf, zf,     uv.left.top_right.u, uv.left.top_right.v, -1, 0, 0, light },
+            { xf-1, yf-1, zf,   uv.left.bottom_right.u, uv.left.bottom_right.v, -1, 0, 0, light },
+            { xf-1, yf-1, zf-1, uv.left.bottom_left.u, uv.left.bottom_left.v, -1, 0, 0, light },
+            { xf-1, yf, zf-1,   uv.left.top_left.u, uv.left.top_left.v, -1, 0, 0, light },
         });
     }
     if (top == VoxelType::NONE) {
+        const float light = get_face_light(x, y + 1, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf, yf, zf-1,     uv.top.top_right.u, uv.top.top_right.v, 0, 1, 0 },
-            { xf, yf, zf,       uv.top.bottom_right.u, uv.top.bottom_right.v, 0, 1, 0 },
-            { xf-1, yf, zf,     uv.top.bottom_left.u, uv.top.bottom_left.v, 0, 1, 0 },
-            { xf-1, yf, zf-1,   uv.top.top_left.u, uv.top.top_left.v, 0, 1, 0 },
+            { xf, yf, zf-1,     uv.top.top_right.u, uv.top.top_right.v, 0, 1, 0, light },
+            { xf, yf, zf,       uv.top.bottom_right.u, uv.top.bottom_right.v, 0, 1, 0, light },
+            { xf-1, yf, zf,     uv.top.bottom_left.u, uv.top.bottom_left.v, 0, 1, 0, light },
+            { xf-1, yf, zf-1,   uv.top.top_left.u, uv.top.top_left.v, 0, 1, 0, light },
         });
     }
     if (bottom == VoxelType::NONE) {
+        const float light = get_face_light(x, y - 1, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf-1, yf-1, zf-1, uv.bottom.top_right.u, uv.bottom.top_right.v, 0, -1, 0 },
-            { xf-1, yf-1, zf,   uv.bottom.bottom_right.u, uv.bottom.bottom_right.v, 0, -1, 0 },
-            { xf, yf-1, zf,     uv.bottom.bottom_left.u, uv.bottom.bottom_left.v, 0, -1, 0 },
-            { xf, yf-1, zf-1,   uv.bottom.top_left.u, uv.bottom.top_left.v, 0, -1, 0 },
+            { xf-1, yf-1, zf-1, uv.bottom.top_right.u, uv.bottom.top_right.v, 0, -1, 0, light },
+            { xf-1, yf-1, zf,   uv.bottom.bottom_right.u, uv.bottom.bottom_right.v, 0, -1, 0, light },
+            { xf, yf-1, zf,     uv.bottom.bottom_left.u, uv.bottom.bottom_left.v, 0, -1, 0, light },
+            { xf, yf-1, zf-1,   uv.bottom.top_left.u, uv.bottom.top_left.v, 0, -1, 0, light },
         });
     }
 }
@@ -230,51 +362,57 @@ void ChunkMesher::add_non_edge_voxel(ChunkMesh& mesh, int x, int y, int z) {
     VoxelUV uv = uv_scheme->uvs.at(chunk->voxels[x][y][z].type);
 
     if (front == VoxelType::NONE) {
+        const float light = get_face_light(x, y, z + 1);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf, yf, zf,       uv.front.top_right.u, uv.front.top_right.v, 0, 0, 1 },
-            { xf, yf-1, zf,     uv.front.bottom_right.u, uv.front.bottom_right.v, 0, 0, 1 },
-            { xf-1, yf-1, zf,   uv.front.bottom_left.u, uv.front.bottom_left.v, 0, 0, 1 },
-            { xf-1, yf, zf,     uv.front.top_left.u, uv.front.top_left.v, 0, 0, 1 }
+            { xf, yf, zf,       uv.front.top_right.u, uv.front.top_right.v, 0, 0, 1, light },
+            { xf, yf-1, zf,     uv.front.bottom_right.u, uv.front.bottom_right.v, 0, 0, 1, light },
+            { xf-1, yf-1, zf,   uv.front.bottom_left.u, uv.front.bottom_left.v, 0, 0, 1, light },
+            { xf-1, yf, zf,     uv.front.top_left.u, uv.front.top_left.v, 0, 0, 1, light }
         });
     }
     if (back == VoxelType::NONE) {
+        const float light = get_face_light(x, y, z - 1);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf-1, yf, zf-1,   uv.back.top_right.u, uv.back.top_right.v, 0, 0, -1 },
-            { xf-1, yf-1, zf-1, uv.back.bottom_right.u, uv.back.bottom_right.v, 0, 0, -1 },
-            { xf, yf-1, zf-1,   uv.back.bottom_left.u, uv.back.bottom_left.v, 0, 0, -1 },
-            { xf, yf, zf-1,     uv.back.top_left.u, uv.back.top_left.v, 0, 0, -1 },
+            { xf-1, yf, zf-1,   uv.back.top_right.u, uv.back.top_right.v, 0, 0, -1, light },
+            { xf-1, yf-1, zf-1, uv.back.bottom_right.u, uv.back.bottom_right.v, 0, 0, -1, light },
+            { xf, yf-1, zf-1,   uv.back.bottom_left.u, uv.back.bottom_left.v, 0, 0, -1, light },
+            { xf, yf, zf-1,     uv.back.top_left.u, uv.back.top_left.v, 0, 0, -1, light },
         });
     }
     if (right == VoxelType::NONE) {
+        const float light = get_face_light(x + 1, y, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf, yf, zf-1,     uv.right.top_right.u, uv.right.top_right.v, 1, 0, 0 },
-            { xf, yf-1, zf-1,   uv.right.bottom_right.u, uv.right.bottom_right.v, 1, 0, 0 },
-            { xf, yf-1, zf,     uv.right.bottom_left.u, uv.right.bottom_left.v, 1, 0, 0 },
-            { xf, yf, zf,       uv.right.top_left.u, uv.right.top_left.v, 1, 0, 0 },
+            { xf, yf, zf-1,     uv.right.top_right.u, uv.right.top_right.v, 1, 0, 0, light },
+            { xf, yf-1, zf-1,   uv.right.bottom_right.u, uv.right.bottom_right.v, 1, 0, 0, light },
+            { xf, yf-1, zf,     uv.right.bottom_left.u, uv.right.bottom_left.v, 1, 0, 0, light },
+            { xf, yf, zf,       uv.right.top_left.u, uv.right.top_left.v, 1, 0, 0, light },
         });
     }
     if (left == VoxelType::NONE) {
+        const float light = get_face_light(x - 1, y, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf-1, yf, zf,     uv.left.top_right.u, uv.left.top_right.v, -1, 0, 0 },
-            { xf-1, yf-1, zf,   uv.left.bottom_right.u, uv.left.bottom_right.v, -1, 0, 0 },
-            { xf-1, yf-1, zf-1, uv.left.bottom_left.u, uv.left.bottom_left.v, -1, 0, 0 },
-            { xf-1, yf, zf-1,   uv.left.top_left.u, uv.left.top_left.v, -1, 0, 0 },
+            { xf-1, yf, zf,     uv.left.top_right.u, uv.left.top_right.v, -1, 0, 0, light },
+            { xf-1, yf-1, zf,   uv.left.bottom_right.u, uv.left.bottom_right.v, -1, 0, 0, light },
+            { xf-1, yf-1, zf-1, uv.left.bottom_left.u, uv.left.bottom_left.v, -1, 0, 0, light },
+            { xf-1, yf, zf-1,   uv.left.top_left.u, uv.left.top_left.v, -1, 0, 0, light },
         });
     }
     if (top == VoxelType::NONE) {
+        const float light = get_face_light(x, y + 1, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf, yf, zf-1,     uv.top.top_right.u, uv.top.top_right.v, 0, 1, 0 },
-            { xf, yf, zf,       uv.top.bottom_right.u, uv.top.bottom_right.v, 0, 1, 0 },
-            { xf-1, yf, zf,     uv.top.bottom_left.u, uv.top.bottom_left.v, 0, 1, 0 },
-            { xf-1, yf, zf-1,   uv.top.top_left.u, uv.top.top_left.v, 0, 1, 0 },
+            { xf, yf, zf-1,     uv.top.top_right.u, uv.top.top_right.v, 0, 1, 0, light },
+            { xf, yf, zf,       uv.top.bottom_right.u, uv.top.bottom_right.v, 0, 1, 0, light },
+            { xf-1, yf, zf,     uv.top.bottom_left.u, uv.top.bottom_left.v, 0, 1, 0, light },
+            { xf-1, yf, zf-1,   uv.top.top_left.u, uv.top.top_left.v, 0, 1, 0, light },
         });
     }
     if (bottom == VoxelType::NONE) {
+        const float light = get_face_light(x, y - 1, z);
         mesh.vertices.insert(mesh.vertices.end(), {
-            { xf-1, yf-1, zf-1, uv.bottom.top_right.u, uv.bottom.top_right.v, 0, -1, 0 },
-            { xf-1, yf-1, zf,   uv.bottom.bottom_right.u, uv.bottom.bottom_right.v, 0, -1, 0 },
-            { xf, yf-1, zf,     uv.bottom.bottom_left.u, uv.bottom.bottom_left.v, 0, -1, 0 },
-            { xf, yf-1, zf-1,   uv.bottom.top_left.u, uv.bottom.top_left.v, 0, -1, 0 },
+            { xf-1, yf-1, zf-1, uv.bottom.top_right.u, uv.bottom.top_right.v, 0, -1, 0, light },
+            { xf-1, yf-1, zf,   uv.bottom.bottom_right.u, uv.bottom.bottom_right.v, 0, -1, 0, light },
+            { xf, yf-1, zf,     uv.bottom.bottom_left.u, uv.bottom.bottom_left.v, 0, -1, 0, light },
+            { xf, yf-1, zf-1,   uv.bottom.top_left.u, uv.bottom.top_left.v, 0, -1, 0, light },
         });
     }
 }
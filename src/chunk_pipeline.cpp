@@ -0,0 +1,131 @@
+#include <chunk_pipeline.hpp>
+
+auto get_stage_name(ChunkStage stage) -> const char* {
+    switch (stage) {
+        case ChunkStage::NONE: return "none";
+        case ChunkStage::TERRAIN: return "terrain";
+        case ChunkStage::SURFACE: return "surface";
+        case ChunkStage::DECORATION: return "decoration";
+        case ChunkStage::LIGHT: return "light";
+        case ChunkStage::MESH: return "mesh";
+        case ChunkStage::UPLOAD: return "upload";
+    }
+    return "unknown";
+}
+
+auto get_neighbour_requirement(ChunkStage stage) -> ChunkStage {
+    switch (stage) {
+        // Features spill through the decoration queue, so generation never
+        // needs neighbours.
+        case ChunkStage::LIGHT: return ChunkStage::DECORATION;
+
+        // Border faces depend on final neighbour voxels.
+        case ChunkStage::MESH: return ChunkStage::LIGHT;
+
+        default: return ChunkStage::NONE;
+    }
+}
+
+void ChunkPipeline::clear_targets() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.stage == ChunkStage::NONE) {
+            it = entries.erase(it);
+        } else {
+            it->second.target = ChunkStage::NONE;
+            it->second.prefetch = false;
+            ++it;
+        }
+    }
+}
+
+void ChunkPipeline::request(ChunkPosition pos, ChunkStage target, bool prefetch) {
+    auto [it, inserted] = entries.try_emplace(get_key(pos), Entry{ pos });
+    auto& entry = it->second;
+
+    // Wanted for a visible chunk beats wanted for a prefetch.
+    if (entry.target == ChunkStage::NONE) {
+        entry.prefetch = prefetch;
+    } else {
+        entry.prefetch = entry.prefetch && prefetch;
+    }
+
+    if (entry.target >= target) {
+        return;
+    }
+    entry.target = target;
+
+    // Requirements only grow with the stage, the last one covers the rest.
+    ChunkStage requirement = ChunkStage::NONE;
+    for (int stage = 1; stage <= static_cast<int>(target); ++stage) {
+        const auto required = get_neighbour_requirement(static_cast<ChunkStage>(stage));
+        if (required > requirement) requirement = required;
+    }
+
+    if (requirement == ChunkStage::NONE) {
+        return;
+    }
+    for (const auto& offset : neighbours) {
+        request(pos + offset, requirement, prefetch);
+    }
+}
+
+auto ChunkPipeline::get_stage(ChunkPosition pos) const -> ChunkStage {
+    const auto* entry = find(pos);
+    return entry ? entry->stage : ChunkStage::NONE;
+}
+
+auto ChunkPipeline::get_target(ChunkPosition pos) const -> ChunkStage {
+    const auto* entry = find(pos);
+    return entry ? entry->target : ChunkStage::NONE;
+}
+
+auto ChunkPipeline::is_prefetch(ChunkPosition pos) const -> bool {
+    const auto* entry = find(pos);
+    return entry && entry->prefetch;
+}
+
+void ChunkPipeline::set_stage(ChunkPosition pos, ChunkStage stage) {
+    entries.try_emplace(get_key(pos), Entry{ pos }).first->second.stage = stage;
+}
+
+void ChunkPipeline::erase(ChunkPosition pos) {
+    entries.erase(get_key(pos));
+}
+
+auto ChunkPipeline::can_run(ChunkPosition pos, ChunkStage stage) const -> bool {
+    const auto* entry = find(pos);
+    if (entry == nullptr || entry->target < stage
+        || static_cast<int>(entry->stage) + 1 != static_cast<int>(stage)) {
+        return false;
+    }
+
+    const auto requirement = get_neighbour_requirement(stage);
+    if (requirement == ChunkStage::NONE) {
+        return true;
+    }
+
+    for (const auto& offset : neighbours) {
+        if (get_stage(pos + offset) < requirement) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChunkPipeline::count_stages(size_t (&counts)[static_cast<int>(ChunkStage::UPLOAD) + 1]) const {
+    for (auto& count : counts) {
+        count = 0;
+    }
+    for (const auto& [key, entry] : entries) {
+        ++counts[static_cast<int>(entry.stage)];
+    }
+}
+
+auto ChunkPipeline::find(ChunkPosition pos) const -> const Entry* {
+    auto it = entries.find(get_key(pos));
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+auto ChunkPipeline::get_key(ChunkPosition pos) -> std::string {
+    return std::to_string(pos.x) + "_" + std::to_string(pos.y) + "_" + std::to_string(pos.z);
+}
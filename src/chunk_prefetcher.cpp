@@ -0,0 +1,62 @@
+#include <chunk_prefetcher.hpp>
+
+#include <unordered_set>
+#include <cmath>
+
+void ChunkPrefetcher::observe(glm::vec3 camera_pos, glm::vec3 camera_front, float dt) {
+    front = camera_front;
+
+    if (!has_last_pos || dt <= 0.0f) {
+        last_pos = camera_pos;
+        has_last_pos = true;
+        return;
+    }
+
+    const glm::vec3 frame_velocity = (camera_pos - last_pos) / dt;
+    velocity += (frame_velocity - velocity) * settings.velocity_smoothing;
+    last_pos = camera_pos;
+}
+
+std::vector<ChunkPosition> ChunkPrefetcher::get_path_columns() const {
+    std::vector<ChunkPosition> columns;
+
+    // Chunks are streamed in columns, vertical motion doesn't matter.
+    const glm::vec2 velocity_xz = { velocity.x, velocity.z };
+    const float speed = glm::length(velocity_xz);
+    if (speed < settings.min_speed) {
+        return columns;
+    }
+
+    glm::vec2 direction = velocity_xz / speed;
+    const glm::vec2 front_xz = { front.x, front.z };
+    if (glm::length(front_xz) > 1e-4f && glm::dot(direction, front_xz) > 0.0f) {
+        direction = glm::normalize(glm::mix(direction, glm::normalize(front_xz), settings.look_weight));
+    }
+
+    const float distance = speed * settings.lookahead_seconds;
+    const glm::vec2 origin = { last_pos.x, last_pos.z };
+
+    // Sample twice per chunk so diagonal paths don't skip columns.
+    const float step = Chunk::Width * 0.5f;
+    const int radius = settings.path_radius;
+
+    std::unordered_set<int64_t> seen;
+    for (float t = step; t <= distance; t += step) {
+        const glm::vec2 point = origin + direction * t;
+        const int cx = static_cast<int>(std::floor(point.x / Chunk::Width));
+        const int cz = static_cast<int>(std::floor(point.y / Chunk::Width));
+
+        for (int x = -radius; x <= radius; ++x) {
+            for (int z = -radius; z <= radius; ++z) {
+                if (x * x + z * z > radius * radius) continue;
+
+                const int64_t key = (static_cast<int64_t>(cx + x) << 32) | static_cast<uint32_t>(cz + z);
+                if (!seen.insert(key).second) continue;
+
+                columns.push_back({ cx + x, 0, cz + z });
+            }
+        }
+    }
+
+    return columns;
+}
@@ -0,0 +1,1067 @@
+#include <chunk_streamer.hpp>
+#include <world_gen.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cmath>
+
+ChunkStreamer::ChunkStreamer(World& world, UVOffsetScheme& uv_scheme, Settings settings,
+    ChunkIO* io, EditJournal* journal)
+    : settings{settings}, column_cache{ get_default_generator(), world.world_size.y },
+      world{world}, uv_scheme{uv_scheme}, generator{get_default_generator()},
+      io{io}, journal{journal}, workers{settings.worker_threads} {
+    if (this->settings.unload_radius <= this->settings.load_radius) {
+        this->settings.unload_radius = this->settings.load_radius + 1;
+    }
+}
+
+ChunkStreamer::ChunkStreamer(World& world, UVOffsetScheme& uv_scheme)
+    : ChunkStreamer(world, uv_scheme, Settings{}) {}
+
+ChunkStreamer::~ChunkStreamer() {
+    unload_all();
+}
+
+void ChunkStreamer::update(glm::vec3 pos, glm::vec3 front) {
+    auto now = std::chrono::steady_clock::now();
+    float dt = std::chrono::duration<float>(now - last_update_time).count();
+    last_update_time = now;
+
+    camera_pos = pos;
+    camera_front = front;
+    camera_chunk = ChunkPosition::from_world_pos(Position{
+        static_cast<int>(std::floor(pos.x)), 0, static_cast<int>(std::floor(pos.z)) });
+
+    prefetcher.observe(pos, front, dt);
+
+    // Turning more than ~30 degrees reorders the queues, otherwise the old
+    // order is close enough and rebuilding every frame is a waste.
+    const bool turned = glm::dot(camera_front, queued_camera_front) < 0.866f;
+    const bool moved = !(camera_chunk == queued_camera_chunk);
+    if (!queues_valid || moved || turned) {
+        if (queues_valid && moved) {
+            record_prefetch_results(queued_camera_chunk);
+        }
+
+        update_targets();
+        unload_far_chunks();
+        rebuild_queues();
+    }
+
+    process_io_completions();
+    add_generated_chunks();
+    apply_late_decorations();
+    apply_light_results();
+    update_checkpoint();
+    upload_meshes();
+
+    int generate_budget = settings.max_generated_per_update;
+    while (generate_budget > 0 && !generate_queue.empty()) {
+        auto item = generate_queue.top();
+        generate_queue.pop();
+
+        // Entries go stale when the camera moves or a chunk was generated
+        // through another path since the queue was built.
+        if (world.get_chunk_at(item.position) != nullptr) continue;
+        if (pipeline.get_target(item.position) == ChunkStage::NONE) continue;
+
+        auto key = world.get_chunk_key(item.position);
+        if (pending_loads.contains(key) || generating.contains(key)) continue;
+        const bool prefetch = pipeline.is_prefetch(item.position);
+
+        // Disk first. Load requests are cheap and don't count against the
+        // generation budget, only the queue depth limits them.
+        if (io && !missing_on_disk.contains(key)) {
+            if (pending_loads.size() >= static_cast<size_t>(settings.max_pending_loads)) {
+                generate_queue.push(item);
+                break;
+            }
+
+            pending_loads.insert({ key, prefetch });
+            io->request_load(item.position);
+            continue;
+        }
+
+        if (generating.size() >= static_cast<size_t>(settings.max_generate_jobs)) {
+            generate_queue.push(item);
+            break;
+        }
+
+        missing_on_disk.erase(key);
+        generate_chunk(item.position, prefetch);
+        --generate_budget;
+    }
+
+    int mesh_budget = settings.max_meshed_per_update;
+    while (mesh_budget > 0 && !mesh_queue.empty()) {
+        auto item = mesh_queue.top();
+        mesh_queue.pop();
+
+        if (meshing.size() >= static_cast<size_t>(settings.max_mesh_jobs)) {
+            mesh_queue.push(item);
+            break;
+        }
+
+        auto key = world.get_chunk_key(item.position);
+        if (meshes.contains(key) || meshing.contains(key)) continue;
+        if (!pipeline.can_run(item.position, ChunkStage::MESH)) continue;
+
+        mesh_chunk(item.position);
+        --mesh_budget;
+    }
+}
+
+void ChunkStreamer::unload_all() {
+    // Completions of pending loads are dropped, every chunk goes away anyway.
+    pending_loads.clear();
+    missing_on_disk.clear();
+
+    if (io) {
+        // Everything gets saved, which makes this a full checkpoint.
+        if (journal && !checkpoint_running) {
+            journal->begin_checkpoint();
+            checkpoint_running = journal->is_checkpointing();
+        }
+
+        for (auto& [key, chunk] : world.loaded_chunks) {
+            save_chunk(chunk.get());
+        }
+        io->wait_idle();
+        process_io_completions();
+
+        if (checkpoint_running) {
+            finish_checkpoint();
+        }
+    }
+
+    for (auto& [key, meshinfo] : meshes) {
+        meshinfo.mesh.destroy_buffers();
+    }
+    meshes.clear();
+    culler.clear();
+
+    // Jobs still running hold their own pins, and their results won't match
+    // a ticket anymore.
+    for (auto& [key, job] : meshing) {
+        *job.cancelled = true;
+    }
+    meshing.clear();
+    {
+        std::lock_guard lock{ mesh_results_mutex };
+        mesh_results.clear();
+    }
+
+    for (auto& [key, job] : generating) {
+        *job.cancelled = true;
+    }
+    generating.clear();
+    {
+        std::lock_guard lock{ generate_results_mutex };
+        generate_results.clear();
+    }
+
+    for (auto& [key, job] : lighting) {
+        *job.cancelled = true;
+    }
+    lighting.clear();
+    {
+        std::lock_guard lock{ light_results_mutex };
+        light_results.clear();
+    }
+
+    world.loaded_chunks.clear();
+    pipeline = {};
+    prefetched_chunks.clear();
+    decorations.clear();
+    late_decorations.clear();
+
+    generate_queue = {};
+    mesh_queue = {};
+    queues_valid = false;
+}
+
+bool ChunkStreamer::set_voxel(Position pos, VoxelType type) {
+    const VoxelType old_type = world.get_voxel_at(pos).type;
+    if (!world.set_voxel_at(pos, type)) {
+        return false;
+    }
+
+    if (journal) {
+        journal->append(pos, type);
+    }
+
+    auto chunk_pos = ChunkPosition::from_world_pos(pos);
+    const int local_x = pos.x - chunk_pos.x * Chunk::Width;
+    const int local_y = pos.y - chunk_pos.y * Chunk::Height;
+    const int local_z = pos.z - chunk_pos.z * Chunk::Width;
+
+    relight_voxel(chunk_pos, local_x, local_y, local_z, old_type);
+    remesh_chunk(chunk_pos);
+
+    // Faces on a chunk border belong to the neighbour's mesh as well.
+    if (local_x == 0) remesh_chunk(chunk_pos + ChunkPosition{ -1, 0, 0 });
+    if (local_x == Chunk::Width - 1) remesh_chunk(chunk_pos + ChunkPosition{ 1, 0, 0 });
+    if (local_y == 0) remesh_chunk(chunk_pos + ChunkPosition{ 0, -1, 0 });
+    if (local_y == Chunk::Height - 1) remesh_chunk(chunk_pos + ChunkPosition{ 0, 1, 0 });
+    if (local_z == 0) remesh_chunk(chunk_pos + ChunkPosition{ 0, 0, -1 });
+    if (local_z == Chunk::Width - 1) remesh_chunk(chunk_pos + ChunkPosition{ 0, 0, 1 });
+
+    return true;
+}
+
+bool ChunkStreamer::compact_chunk(ChunkPosition pos) {
+    Chunk* chunk = world.get_chunk_at(pos);
+    if (!io || chunk == nullptr) {
+        return false;
+    }
+
+    RegionStorage::compact(*chunk);
+    chunk->dirty = true;
+    save_chunk(chunk);
+    return true;
+}
+
+float ChunkStreamer::get_priority(ChunkPosition pos) const {
+    const glm::vec2 to_chunk = {
+        static_cast<float>(pos.x - camera_chunk.x),
+        static_cast<float>(pos.z - camera_chunk.z)
+    };
+    const float distance = glm::length(to_chunk);
+
+    // The camera's own column and its direct neighbours are always needed,
+    // regardless of where the camera looks.
+    if (distance < 1.5f) {
+        return distance;
+    }
+
+    const glm::vec2 front_xz = { camera_front.x, camera_front.z };
+    const float front_length = glm::length(front_xz);
+    if (front_length < 1e-4f) {
+        return distance;
+    }
+
+    // 0 when the chunk is straight ahead, 1 when it is directly behind.
+    const float facing = glm::dot(to_chunk / distance, front_xz / front_length);
+    const float behind = 0.5f * (1.0f - facing);
+
+    return distance * (1.0f + settings.view_weight * behind);
+}
+
+bool ChunkStreamer::is_column_in_radius(ChunkPosition pos, int radius) const {
+    const int dx = pos.x - camera_chunk.x;
+    const int dz = pos.z - camera_chunk.z;
+    return dx * dx + dz * dz <= radius * radius;
+}
+
+void ChunkStreamer::update_targets() {
+    pipeline.clear_targets();
+
+    for (int x = -settings.load_radius; x <= settings.load_radius; ++x) {
+        for (int z = -settings.load_radius; z <= settings.load_radius; ++z) {
+            for (int y = 0; y < world.world_size.y; ++y) {
+                auto pos = ChunkPosition{ camera_chunk.x + x, y, camera_chunk.z + z };
+                if (is_column_in_radius(pos, settings.load_radius)) {
+                    pipeline.request(pos, ChunkStage::UPLOAD);
+                }
+            }
+        }
+    }
+
+    for (auto column : prefetcher.get_path_columns()) {
+        // Anything past the unload radius would be thrown away on the next
+        // rebuild before the camera gets there.
+        if (!is_column_in_radius(column, settings.unload_radius)) continue;
+
+        for (int y = 0; y < world.world_size.y; ++y) {
+            pipeline.request({ column.x, y, column.z }, ChunkStage::UPLOAD, true);
+        }
+    }
+}
+
+void ChunkStreamer::rebuild_queues() {
+    generate_queue = {};
+    mesh_queue = {};
+
+    std::vector<ChunkPosition> ready;
+    for (const auto& [key, entry] : pipeline.get_entries()) {
+        if (entry.target == ChunkStage::NONE) continue;
+        const auto pos = entry.position;
+
+        // Path columns are already ordered by arrival, so distance alone is
+        // enough to interleave them with regular work without the view penalty.
+        const float priority = entry.prefetch
+            ? glm::length(glm::vec2{ static_cast<float>(pos.x - camera_chunk.x), static_cast<float>(pos.z - camera_chunk.z) })
+            : get_priority(pos);
+
+        if (entry.stage == ChunkStage::NONE) {
+            generate_queue.push({ priority, pos });
+        } else if (pipeline.can_run(pos, ChunkStage::MESH)) {
+            if (!meshing.contains(key)) mesh_queue.push({ priority, pos });
+        } else if (entry.stage < entry.target) {
+            // Targets moved, so may have whatever their stages wait for.
+            ready.push_back(pos);
+        }
+    }
+
+    for (auto pos : ready) {
+        advance_stages(pos);
+    }
+
+    queued_camera_chunk = camera_chunk;
+    queued_camera_front = camera_front;
+    queues_valid = true;
+}
+
+void ChunkStreamer::record_prefetch_results(ChunkPosition old_chunk) {
+    const int radius = settings.load_radius;
+
+    for (int x = -radius; x <= radius; ++x) {
+        for (int z = -radius; z <= radius; ++z) {
+            if (x * x + z * z > radius * radius) continue;
+
+            auto column = ChunkPosition{ camera_chunk.x + x, 0, camera_chunk.z + z };
+            const int old_dx = column.x - old_chunk.x;
+            const int old_dz = column.z - old_chunk.z;
+            if (old_dx * old_dx + old_dz * old_dz <= radius * radius) continue;
+
+            auto key = world.get_chunk_key(column);
+            if (!meshes.contains(key)) {
+                ++prefetcher.stats.misses;
+            } else if (prefetched_chunks.contains(key)) {
+                ++prefetcher.stats.hits;
+            }
+
+            // The column is inside the load radius now and no longer counts
+            // as prefetched.
+            for (int y = 0; y < world.world_size.y; ++y) {
+                prefetched_chunks.erase(world.get_chunk_key({ column.x, y, column.z }));
+            }
+        }
+    }
+}
+
+void ChunkStreamer::unload_far_chunks() {
+    for (auto it = meshes.begin(); it != meshes.end();) {
+        if (!is_column_in_radius(it->second.position, settings.unload_radius)) {
+            it->second.mesh.destroy_buffers();
+
+            // The chunk itself may stay, and gets meshed again on the way back.
+            if (pipeline.get_stage(it->second.position) == ChunkStage::UPLOAD) {
+                pipeline.set_stage(it->second.position, ChunkStage::LIGHT);
+            }
+            culler.erase(it->second.position);
+            it = meshes.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = meshing.begin(); it != meshing.end();) {
+        if (!is_column_in_radius(it->second.position, settings.unload_radius)) {
+            *it->second.cancelled = true;
+            it = meshing.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = generating.begin(); it != generating.end();) {
+        if (!is_column_in_radius(it->second.position, settings.unload_radius + DependencyRadius)) {
+            *it->second.cancelled = true;
+            it = generating.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = lighting.begin(); it != lighting.end();) {
+        if (!is_column_in_radius(it->second.position, settings.unload_radius + DependencyRadius)) {
+            *it->second.cancelled = true;
+            it = lighting.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = missing_on_disk.begin(); it != missing_on_disk.end();) {
+        if (!is_column_in_radius(it->second, settings.unload_radius + DependencyRadius)) {
+            it = missing_on_disk.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Chunks are kept as long as a mesh may depend on them, so the border
+    // of the meshed area never loses its neighbours.
+    for (auto it = world.loaded_chunks.begin(); it != world.loaded_chunks.end();) {
+        if (!is_column_in_radius(it->second->position, settings.unload_radius + DependencyRadius)) {
+            if (prefetched_chunks.erase(it->first) > 0) {
+                ++prefetcher.stats.wasted;
+            }
+
+            save_chunk(it->second.get());
+            decorations.release(it->second->position);
+            pipeline.erase(it->second->position);
+            it = world.loaded_chunks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // Features reach one column past the chunk they start in, so spill is
+    // kept as long as the chunk it came from may still be loaded.
+    decorations.evict([this](ChunkPosition pos) {
+        return is_column_in_radius(pos, settings.unload_radius + DependencyRadius + 1);
+    });
+}
+
+void ChunkStreamer::generate_chunk(ChunkPosition pos, bool prefetch) {
+    auto key = world.get_chunk_key(pos);
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+    generating[key] = { pos, prefetch, cancelled };
+
+    workers.submit([this, key, pos, cancelled] {
+        if (*cancelled) {
+            return;
+        }
+
+        auto chunk = std::make_shared<Chunk>();
+        chunk->position = pos;
+        chunk->fill(VoxelType::NONE);
+
+        // Stages that don't depend on neighbours run back to back, up to
+        // and including decoration.
+        const auto fields = column_cache.get(pos);
+        generator.populate_terrain(*chunk, *fields);
+        generator.populate_surface(*chunk, *fields);
+
+        std::vector<FeatureSpill> spill;
+        generator.decorate(*chunk, *fields, spill);
+        for (auto& neighbour_spill : spill) {
+            decorations.push(std::move(neighbour_spill));
+        }
+        for (const auto& queued : decorations.claim(pos)) {
+            apply_feature_spill(*chunk, queued);
+        }
+
+        std::lock_guard lock{ generate_results_mutex };
+        generate_results.push_back({ key, std::move(chunk) });
+    });
+}
+
+void ChunkStreamer::add_generated_chunks() {
+    std::vector<GenerateResult> results;
+    {
+        std::lock_guard lock{ generate_results_mutex };
+        results.swap(generate_results);
+    }
+
+    for (auto& result : results) {
+        auto job = generating.find(result.key);
+        if (job == generating.end()) {
+            // Cancelled after it claimed. The voxels it claimed are still
+            // queued, and so are later ones, for the chunk's next claim.
+            if (world.get_chunk_at(result.chunk->position) == nullptr) {
+                decorations.release(result.chunk->position);
+            }
+            continue;
+        }
+
+        const bool prefetch = job->second.prefetch;
+        generating.erase(job);
+
+        auto chunk = std::move(result.chunk);
+        const auto pos = chunk->position;
+        if (world.get_chunk_at(pos) != nullptr) continue;
+
+        // In delta mode an unedited chunk is fully described by the seed.
+        if (io && io->get_storage().settings.save_mode == SaveMode::FULL) {
+            chunk->dirty = true;
+            save_chunk(chunk.get());
+        }
+
+        add_chunk(std::move(chunk), prefetch);
+        pipeline.set_stage(pos, ChunkStage::DECORATION);
+        advance_stages(pos);
+    }
+}
+
+void ChunkStreamer::apply_late_decorations() {
+    for (auto& spill : decorations.take_late()) {
+        late_decorations.push_back(std::move(spill));
+    }
+
+    std::vector<FeatureSpill> waiting;
+    for (auto& spill : late_decorations) {
+        const auto pos = spill.target;
+        if (world.get_chunk_at(pos) == nullptr) {
+            // Its generation job claimed, but the result isn't in yet. If
+            // the chunk is gone instead, the queue keeps them for its next
+            // claim.
+            if (generating.contains(world.get_chunk_key(pos))) {
+                waiting.push_back(std::move(spill));
+            }
+            continue;
+        }
+
+        // Skipped before copying a pinned chunk if it has this spill already.
+        if (world.get_chunk_at(pos)->spill_sources & get_spill_bit(spill.source, pos)) {
+            continue;
+        }
+        if (!apply_feature_spill(*world.get_writable_chunk(pos), spill)) {
+            continue;
+        }
+
+        int min_x = Chunk::Width, max_x = 0, min_z = Chunk::Width, max_z = 0;
+        for (const auto& voxel : spill.voxels) {
+            min_x = std::min<int>(min_x, voxel.x);
+            max_x = std::max<int>(max_x, voxel.x);
+            min_z = std::min<int>(min_z, voxel.z);
+            max_z = std::max<int>(max_z, voxel.z);
+        }
+        relight_around(pos, min_x, max_x, min_z, max_z);
+
+        // Neighbours only need a remesh if a voxel on their side changed.
+        bool borders[4] = {};
+        for (const auto& voxel : spill.voxels) {
+            borders[0] |= voxel.x == 0;
+            borders[1] |= voxel.x == Chunk::Width - 1;
+            borders[2] |= voxel.z == 0;
+            borders[3] |= voxel.z == Chunk::Width - 1;
+        }
+
+        remesh_chunk(pos);
+        if (borders[0]) remesh_chunk(pos + ChunkPosition{ -1, 0, 0 });
+        if (borders[1]) remesh_chunk(pos + ChunkPosition{ 1, 0, 0 });
+        if (borders[2]) remesh_chunk(pos + ChunkPosition{ 0, 0, -1 });
+        if (borders[3]) remesh_chunk(pos + ChunkPosition{ 0, 0, 1 });
+    }
+    late_decorations.swap(waiting);
+}
+
+void ChunkStreamer::light_chunk(ChunkPosition pos) {
+    auto key = world.get_chunk_key(pos);
+    const auto ticket = next_light_ticket++;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+
+    auto& job = lighting[key];
+    if (job.cancelled) {
+        *job.cancelled = true;
+    }
+    job = { ticket, pos, cancelled };
+
+    workers.submit([this, snapshot = LightSnapshot::pin(world, pos), key, pos, ticket, cancelled] {
+        if (*cancelled) {
+            return;
+        }
+
+        auto skylight = std::make_unique<Chunk::LightLevels>();
+        auto blocklight = std::make_unique<Chunk::LightLevels>();
+        compute_skylight(snapshot, *skylight);
+        compute_blocklight(snapshot, *blocklight);
+
+        std::lock_guard lock{ light_results_mutex };
+        light_results.push_back({ key, pos, ticket, std::move(skylight), std::move(blocklight) });
+    });
+}
+
+void ChunkStreamer::apply_light_results() {
+    std::vector<LightResult> results;
+    {
+        std::lock_guard lock{ light_results_mutex };
+        results.swap(light_results);
+    }
+
+    for (auto& result : results) {
+        auto job = lighting.find(result.key);
+        if (job == lighting.end() || job->second.ticket != result.ticket) continue;
+        lighting.erase(job);
+
+        Chunk* chunk = world.get_writable_chunk(result.position);
+        if (chunk == nullptr) continue;
+        chunk->skylight = *result.skylight;
+        chunk->blocklight = *result.blocklight;
+
+        if (pipeline.get_stage(result.position) == ChunkStage::DECORATION) {
+            pipeline.set_stage(result.position, ChunkStage::LIGHT);
+            advance_stages(result.position);
+        }
+    }
+}
+
+void ChunkStreamer::relight_around(ChunkPosition pos, int min_x, int max_x, int min_z, int max_z) {
+    // Mesh jobs pin their neighbours, so they only start once every chunk
+    // here has its new light. Starting them earlier would copy the next
+    // chunks on write.
+    std::vector<ChunkPosition> remeshes;
+    auto remesh = [&](ChunkPosition target) {
+        if (std::find(remeshes.begin(), remeshes.end(), target) == remeshes.end()) {
+            remeshes.push_back(target);
+        }
+    };
+
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            const auto target = pos + ChunkPosition{ dx, 0, dz };
+
+            // Light spreads one voxel per level, so changes only reach the
+            // neighbours within that many steps.
+            const int distance_x = (dx < 0) ? min_x + 1 : (dx > 0) ? Chunk::Width - max_x : 0;
+            const int distance_z = (dz < 0) ? min_z + 1 : (dz > 0) ? Chunk::Width - max_z : 0;
+            if (distance_x + distance_z >= Chunk::MaxLight) continue;
+
+            if (lighting.contains(world.get_chunk_key(target))) {
+                light_chunk(target);
+                continue;
+            }
+            if (pipeline.get_stage(target) < ChunkStage::LIGHT) continue;
+
+            // Neighbours only need a remesh if the light on their side changed.
+            Chunk::LightLevels skylight, blocklight;
+            bool changed = false;
+            bool borders[4] = {};
+            auto compare = [&](const Chunk::LightLevels& old, const Chunk::LightLevels& light) {
+                if (std::memcmp(old.data, light.data, sizeof light.data) == 0) return;
+                changed = true;
+                borders[0] |= std::memcmp(old.data[0], light.data[0], sizeof light.data[0]) != 0;
+                borders[1] |= std::memcmp(old.data[Chunk::Width - 1], light.data[Chunk::Width - 1], sizeof light.data[0]) != 0;
+                for (int x = 0; x < Chunk::Width; ++x) {
+                    for (int y = 0; y < Chunk::Height; ++y) {
+                        borders[2] |= ((old.data[x][y][0] ^ light.data[x][y][0]) & 0x0F) != 0;
+                        borders[3] |= ((old.data[x][y][Chunk::Width / 2 - 1] ^ light.data[x][y][Chunk::Width / 2 - 1]) & 0xF0) != 0;
+                    }
+                }
+            };
+
+            {
+                // The pin holds the chunk too, it must be gone before the
+                // chunk is made writable or every relight copies it.
+                const auto snapshot = LightSnapshot::pin(world, target);
+                compute_skylight(snapshot, skylight);
+                compute_blocklight(snapshot, blocklight);
+                compare(snapshot.get_chunk()->skylight, skylight);
+                compare(snapshot.get_chunk()->blocklight, blocklight);
+            }
+
+            if (!changed) continue;
+            Chunk* chunk = world.get_writable_chunk(target);
+            chunk->skylight = skylight;
+            chunk->blocklight = blocklight;
+
+            remesh(target);
+            if (borders[0]) remesh(target + ChunkPosition{ -1, 0, 0 });
+            if (borders[1]) remesh(target + ChunkPosition{ 1, 0, 0 });
+            if (borders[2]) remesh(target + ChunkPosition{ 0, 0, -1 });
+            if (borders[3]) remesh(target + ChunkPosition{ 0, 0, 1 });
+        }
+    }
+
+    for (auto target : remeshes) {
+        remesh_chunk(target);
+    }
+}
+
+void ChunkStreamer::relight_voxel(ChunkPosition pos, int x, int y, int z, VoxelType old_type) {
+    // Not lit yet, so there's no light to update incrementally, and its
+    // light job will see the edit. Lit neighbours the edit's light reaches
+    // are relit from scratch instead.
+    if (pipeline.get_stage(pos) < ChunkStage::LIGHT) {
+        relight_around(pos, x, x, z, z);
+        return;
+    }
+
+    // Light jobs in flight read the voxels from before the edit.
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            const auto target = pos + ChunkPosition{ dx, 0, dz };
+            if (lighting.contains(world.get_chunk_key(target))) {
+                light_chunk(target);
+            }
+        }
+    }
+
+    LightEditor editor{ world, pos };
+    editor.update(x, y, z, old_type);
+
+    // Meshes are per chunk, a changed section means a whole remesh.
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            if (editor.get_changed_sections(dx, dz) != 0) {
+                remesh_chunk(pos + ChunkPosition{ dx, 0, dz });
+            }
+        }
+    }
+}
+
+void ChunkStreamer::save_chunk(Chunk* chunk) {
+    if (!io || !chunk->dirty) {
+        return;
+    }
+
+    io->request_save(chunk->position, io->get_storage().encode_for_save(*chunk));
+    chunk->dirty = false;
+}
+
+void ChunkStreamer::add_chunk(std::shared_ptr<Chunk> chunk, bool prefetch) {
+    auto key = world.get_chunk_key(chunk->position);
+    const bool prefetched = prefetch && !is_column_in_radius(chunk->position, settings.load_radius);
+    world.loaded_chunks.insert({ key, std::move(chunk) });
+
+    if (prefetched) {
+        prefetched_chunks.insert(key);
+        ++prefetcher.stats.prefetched;
+    }
+}
+
+void ChunkStreamer::process_io_completions() {
+    if (!io) {
+        return;
+    }
+
+    for (auto& completion : io->poll()) {
+        if (completion.type == ChunkIO::Completion::Type::SAVE) {
+            if (!completion.success) {
+                save_failed = true;
+
+                // Try again on the next unload or checkpoint.
+                if (Chunk* chunk = world.get_chunk_at(completion.position)) {
+                    chunk->dirty = true;
+                } else {
+                    save_lost = true;
+                }
+            }
+            continue;
+        }
+
+        const auto pos = completion.position;
+        auto key = world.get_chunk_key(pos);
+
+        auto pending = pending_loads.find(key);
+        if (pending == pending_loads.end()) continue;
+
+        const bool prefetch = pending->second;
+        pending_loads.erase(pending);
+
+        if (world.get_chunk_at(pos) != nullptr) continue;
+        if (pipeline.get_target(pos) == ChunkStage::NONE) continue;
+
+        if (completion.success) {
+            auto chunk = std::make_shared<Chunk>();
+            chunk->position = pos;
+
+            if (RegionStorage::decode_payload(completion.payload, *chunk)) {
+                // Saved voxels have the spill of the neighbours in
+                // `spill_sources`, delta payloads all of it. Only spill from
+                // the others is applied.
+                for (const auto& queued : decorations.claim(pos)) {
+                    apply_feature_spill(*chunk, queued);
+                }
+
+                // Its own spill, for neighbours that come after it. It wasn't
+                // generated, but what it spills only depends on its position.
+                std::vector<FeatureSpill> spill;
+                generator.get_spill(pos, spill);
+                for (auto& neighbour_spill : spill) {
+                    decorations.push(std::move(neighbour_spill));
+                }
+                add_chunk(std::move(chunk), prefetch);
+                pipeline.set_stage(pos, ChunkStage::DECORATION);
+                advance_stages(pos);
+                continue;
+            }
+
+            std::cerr << "Chunk " << key << " is corrupt on disk, regenerating.\n";
+        }
+
+        missing_on_disk.insert({ key, pos });
+        generate_queue.push({ get_priority(pos), pos });
+    }
+}
+
+void ChunkStreamer::update_checkpoint() {
+    if (!io || !journal) {
+        return;
+    }
+
+    if (!checkpoint_running) {
+        if (!journal->is_checkpoint_due()) {
+            return;
+        }
+
+        // Edits made from here on go to the new generation, everything in
+        // the sealed one is covered by these saves. Chunks edited and
+        // unloaded earlier have their saves in flight already.
+        journal->begin_checkpoint();
+        checkpoint_running = journal->is_checkpointing();
+
+        for (auto& [key, chunk] : world.loaded_chunks) {
+            save_chunk(chunk.get());
+        }
+        checkpoint_save_sequence = io->get_last_save_sequence();
+        return;
+    }
+
+    if (io->is_saved_through(checkpoint_save_sequence)) {
+        finish_checkpoint();
+    }
+}
+
+void ChunkStreamer::finish_checkpoint() {
+    if (save_failed || save_lost) {
+        if (save_failed) {
+            std::cerr << "Chunk saves failed, keeping the edit journal.\n";
+        }
+        journal->abandon_checkpoint();
+        save_failed = false;
+    } else {
+        journal->finish_checkpoint(io->get_storage().get_regions());
+    }
+
+    checkpoint_running = false;
+    checkpoint_save_sequence = 0;
+}
+
+void ChunkStreamer::mesh_chunk(ChunkPosition pos) {
+    auto key = world.get_chunk_key(pos);
+    const auto ticket = next_mesh_ticket++;
+    auto cancelled = std::make_shared<std::atomic<bool>>(false);
+
+    auto& job = meshing[key];
+    if (job.cancelled) {
+        *job.cancelled = true;
+    }
+    job = { ticket, pos, cancelled };
+
+    workers.submit([this, snapshot = ChunkSnapshot::pin(world, pos), key, pos, ticket, cancelled] {
+        if (*cancelled) {
+            return;
+        }
+
+        auto mesh = ChunkMesher(snapshot, &uv_scheme).generate_mesh();
+
+        std::lock_guard lock{ mesh_results_mutex };
+        mesh_results.push_back({ key, pos, ticket, std::move(mesh) });
+    });
+}
+
+void ChunkStreamer::remesh_chunk(ChunkPosition pos) {
+    // The current mesh stays up until its replacement is uploaded.
+    auto key = world.get_chunk_key(pos);
+    if (meshes.contains(key) || meshing.contains(key)) {
+        mesh_chunk(pos);
+    }
+}
+
+void ChunkStreamer::get_visible_meshes(const Frustum& frustum, std::vector<const CoordChunkMesh*>& visible) const {
+    static thread_local std::vector<ChunkPosition> positions;
+    positions.clear();
+    culler.cull(frustum, positions);
+
+    for (const auto& pos : positions) {
+        auto it = meshes.find(world.get_chunk_key(pos));
+        if (it != meshes.end()) {
+            visible.push_back(&it->second);
+        }
+    }
+}
+
+void ChunkStreamer::get_visible_sections(const Frustum& frustum, const glm::vec3& camera_pos,
+    std::vector<VisibleChunk>& visible) const {
+    using Face = Chunk::Face;
+    static constexpr uint16_t AllSections = (1u << Chunk::SectionCount) - 1;
+
+    const Position camera{
+        static_cast<int>(std::floor(camera_pos.x)),
+        static_cast<int>(std::floor(camera_pos.y)),
+        static_cast<int>(std::floor(camera_pos.z)) };
+    const auto start = ChunkPosition::from_world_pos(camera);
+
+    auto start_mesh = meshes.find(world.get_chunk_key(start));
+    if (start.y < 0 || start.y >= world.world_size.y || start_mesh == meshes.end()) {
+        static thread_local std::vector<const CoordChunkMesh*> fallback;
+        fallback.clear();
+        get_visible_meshes(frustum, fallback);
+        for (const auto* mesh : fallback) {
+            visible.push_back({ mesh, AllSections });
+        }
+        return;
+    }
+
+    // Indices into `visible` by chunk, or `Missing` for chunks without a
+    // mesh, so each chunk is looked up once.
+    static constexpr size_t Missing = SIZE_MAX;
+    static thread_local std::unordered_map<int64_t, size_t> chunk_indices;
+    chunk_indices.clear();
+
+    auto get_entry = [&](ChunkPosition pos) -> VisibleChunk* {
+        const int64_t key = (static_cast<int64_t>(pos.x) << 40) ^ (static_cast<int64_t>(pos.y) << 20) ^ static_cast<uint32_t>(pos.z & 0xFFFFF);
+        auto [it, inserted] = chunk_indices.try_emplace(key, Missing);
+        if (inserted) {
+            auto mesh = meshes.find(world.get_chunk_key(pos));
+            if (mesh != meshes.end()) {
+                it->second = visible.size();
+                visible.push_back({ &mesh->second, 0 });
+            }
+        }
+        return (it->second == Missing) ? nullptr : &visible[it->second];
+    };
+
+    struct Node {
+        ChunkPosition chunk;
+        int section;
+
+        // Face the section was entered through, -1 for the camera's.
+        int entered;
+
+        // Directions taken to get here, one bit per face.
+        uint8_t directions;
+    };
+    static thread_local std::vector<Node> queue;
+    queue.clear();
+
+    const int start_section = (camera.y - start.y * Chunk::Height) / Chunk::SectionHeight;
+    get_entry(start)->sections |= static_cast<uint16_t>(1u << start_section);
+    queue.push_back({ start, start_section, -1, 0 });
+
+    static constexpr ChunkPosition offsets[Chunk::FaceCount] = {
+        { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }
+    };
+
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const Node node = queue[head];
+        const auto& connectivity = get_entry(node.chunk)->mesh->mesh.section_connectivity[node.section];
+
+        for (int face = 0; face < Chunk::FaceCount; ++face) {
+            // Faces come in pairs, negative first.
+            const int opposite = face ^ 1;
+            if ((node.directions >> opposite) & 1) continue;
+            if (node.entered >= 0 && !connectivity.connects(static_cast<Face>(node.entered), static_cast<Face>(face))) continue;
+
+            auto chunk = node.chunk;
+            int section = node.section;
+            if (face == static_cast<int>(Face::Y_NEG) || face == static_cast<int>(Face::Y_POS)) {
+                section += offsets[face].y;
+                if (section < 0 || section >= Chunk::SectionCount) {
+                    chunk = chunk + ChunkPosition{ 0, offsets[face].y, 0 };
+                    section = (section + Chunk::SectionCount) % Chunk::SectionCount;
+                }
+            } else {
+                chunk = chunk + offsets[face];
+            }
+            if (chunk.y < 0 || chunk.y >= world.world_size.y) continue;
+
+            const glm::vec3 min{
+                Chunk::Width * chunk.x,
+                Chunk::Height * chunk.y + Chunk::SectionHeight * section,
+                Chunk::Width * chunk.z };
+            if (!frustum.intersects(min, min + glm::vec3{ Chunk::Width, Chunk::SectionHeight, Chunk::Width })) continue;
+
+            auto* entry = get_entry(chunk);
+            const auto bit = static_cast<uint16_t>(1u << section);
+            if (entry == nullptr || (entry->sections & bit)) continue;
+
+            entry->sections |= bit;
+            queue.push_back({ chunk, section, opposite, static_cast<uint8_t>(node.directions | (1u << face)) });
+        }
+    }
+}
+
+void ChunkStreamer::get_occluders(const glm::vec3& camera_pos, int radius, std::vector<OcclusionBox>& occluders) const {
+    const auto center = ChunkPosition::from_world_pos(Position{
+        static_cast<int>(std::floor(camera_pos.x)), 0, static_cast<int>(std::floor(camera_pos.z)) });
+
+    for (int dx = -radius; dx <= radius; ++dx) {
+        for (int dz = -radius; dz <= radius; ++dz) {
+            for (int y = 0; y < world.world_size.y; ++y) {
+                const auto pos = ChunkPosition{ center.x + dx, y, center.z + dz };
+                auto it = meshes.find(world.get_chunk_key(pos));
+                if (it == meshes.end()) continue;
+
+                constexpr int Group = ChunkOccluders::GroupWidth;
+                const auto& chunk_occluders = it->second.mesh.occluders;
+                for (int gx = 0; gx < ChunkOccluders::GroupCount; ++gx) {
+                    for (int gz = 0; gz < ChunkOccluders::GroupCount; ++gz) {
+                        const int bottom = chunk_occluders.bottom[gx][gz];
+                        const int top = chunk_occluders.top[gx][gz];
+                        if (bottom >= top) continue;
+
+                        const glm::vec3 min{ Chunk::Width * pos.x + Group * gx, Chunk::Height * pos.y + bottom, Chunk::Width * pos.z + Group * gz };
+                        occluders.push_back({ min, min + glm::vec3{ Group, top - bottom, Group } });
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ChunkStreamer::upload_meshes() {
+    std::vector<MeshResult> results;
+    {
+        std::lock_guard lock{ mesh_results_mutex };
+        results.swap(mesh_results);
+    }
+
+    for (auto& result : results) {
+        auto job = meshing.find(result.key);
+        if (job == meshing.end() || job->second.ticket != result.ticket) continue;
+        meshing.erase(job);
+
+        // The chunk may have gone out of range while the job ran.
+        if (world.get_chunk_at(result.position) == nullptr) continue;
+        if (!is_column_in_radius(result.position, settings.unload_radius)) continue;
+
+        auto& mesh = result.mesh;
+        mesh.upload_buffers();
+        auto size = mesh.indices.size();
+
+        CoordChunkMesh meshinfo{ {}, result.position, size };
+        if (!mesh.vertices.empty()) {
+            meshinfo.bounds_min = meshinfo.bounds_max = { mesh.vertices[0].x, mesh.vertices[0].y, mesh.vertices[0].z };
+            for (const auto& vertex : mesh.vertices) {
+                meshinfo.bounds_min = glm::min(meshinfo.bounds_min, glm::vec3{ vertex.x, vertex.y, vertex.z });
+                meshinfo.bounds_max = glm::max(meshinfo.bounds_max, glm::vec3{ vertex.x, vertex.y, vertex.z });
+            }
+        }
+
+        if (size > 0) {
+            culler.insert(result.position, meshinfo.get_origin() + meshinfo.bounds_min, meshinfo.get_origin() + meshinfo.bounds_max);
+        } else {
+            culler.erase(result.position);
+        }
+
+        // GPU has its own copy, no reason to keep these around.
+        mesh.release_cpu_memory();
+
+        auto old = meshes.find(result.key);
+        if (old != meshes.end()) {
+            old->second.mesh.destroy_buffers();
+        }
+        meshinfo.mesh = std::move(mesh);
+        meshes.insert_or_assign(result.key, std::move(meshinfo));
+        pipeline.set_stage(result.position, ChunkStage::UPLOAD);
+    }
+}
+
+void ChunkStreamer::advance_stages(ChunkPosition pos) {
+    static constexpr ChunkPosition offsets[] = {
+        { 0, 0, 0 },
+        { -1, 0, -1 }, { 0, 0, -1 }, { 1, 0, -1 },
+        { -1, 0, 0 }, { 1, 0, 0 },
+        { -1, 0, 1 }, { 0, 0, 1 }, { 1, 0, 1 }
+    };
+
+    // A chunk moving forward may unblock itself and its neighbours. Stages
+    // only start here, they finish later in a job, whose result calls this
+    // again for the chunk it moved. That's how it spreads further out.
+    for (const auto& offset : offsets) {
+        const auto candidate = pos + offset;
+
+        if (pipeline.can_run(candidate, ChunkStage::LIGHT)) {
+            if (!lighting.contains(world.get_chunk_key(candidate))) light_chunk(candidate);
+        } else if (pipeline.can_run(candidate, ChunkStage::MESH)
+            && !meshing.contains(world.get_chunk_key(candidate))) {
+            mesh_queue.push({ get_priority(candidate), candidate });
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#include <climate_map.hpp>
+
+namespace {
+    // Division rounding towards negative infinity.
+    constexpr auto floor_div(int a, int b) -> int {
+        return (a >= 0) ? a / b : (a - b + 1) / b;
+    }
+}
+
+ClimateMap::ClimateMap(const NoiseSource& temperature, const NoiseSource& humidity,
+        float scale, int octaves, size_t capacity)
+    : temperature{temperature}, humidity{humidity}, scale{scale}, octaves{octaves}, capacity{capacity} {}
+
+auto ClimateMap::get_column(int x, int z) const -> ColumnBiome {
+    const int region_x = floor_div(x, RegionSize);
+    const int region_z = floor_div(z, RegionSize);
+    const auto region = get_region(region_x, region_z);
+
+    return blend(*region, x - region_x * RegionSize, z - region_z * RegionSize);
+}
+
+void ClimateMap::get_columns(ChunkPosition pos, ColumnBiome (&out)[Chunk::Width][Chunk::Width]) const {
+    // A chunk column never straddles two regions.
+    const int region_x = floor_div(pos.x, RegionChunks);
+    const int region_z = floor_div(pos.z, RegionChunks);
+    const auto region = get_region(region_x, region_z);
+
+    const int origin_x = (pos.x - region_x * RegionChunks) * Chunk::Width;
+    const int origin_z = (pos.z - region_z * RegionChunks) * Chunk::Width;
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int z = 0; z < Chunk::Width; ++z) {
+            out[x][z] = blend(*region, origin_x + x, origin_z + z);
+        }
+    }
+}
+
+auto ClimateMap::get_region(int region_x, int region_z) const -> std::shared_ptr<const Region> {
+    std::shared_ptr<Region> region;
+    {
+        std::lock_guard lock{ mutex };
+
+        auto key = std::to_string(region_x) + "," + std::to_string(region_z);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            lru.splice(lru.begin(), lru, it->second.lru_position);
+        } else {
+            lru.push_front(key);
+            it = entries.insert({ std::move(key), Entry{ std::make_shared<Region>(), lru.begin() } }).first;
+        }
+        region = it->second.region;
+
+        if (entries.size() > capacity) {
+            entries.erase(lru.back());
+            lru.pop_back();
+        }
+    }
+
+    std::call_once(region->computed, [&] {
+        compute_region(*region, region_x, region_z);
+    });
+    return region;
+}
+
+void ClimateMap::compute_region(Region& region, int region_x, int region_z) const {
+    // In lattice units, so neighbouring regions compute their shared points
+    // from the same coordinates.
+    const int lattice_x = region_x * (Points - 1);
+    const int lattice_z = region_z * (Points - 1);
+
+    temperature.octave2D({ &region.temperature[0][0], Points * Points },
+        lattice_x, lattice_z, Points, Points, scale * Step, octaves);
+    humidity.octave2D({ &region.humidity[0][0], Points * Points },
+        lattice_x, lattice_z, Points, Points, scale * Step, octaves);
+
+    for (int x = 0; x < Points; ++x) {
+        for (int z = 0; z < Points; ++z) {
+            const auto& info = get_biome_info(classify_biome(region.temperature[x][z], region.humidity[x][z]));
+            region.height_offset[x][z] = info.height_offset;
+            region.height_scale[x][z] = info.height_scale;
+        }
+    }
+}
+
+auto ClimateMap::blend(const Region& region, int x, int z) -> ColumnBiome {
+    const int cell_x = x / Step;
+    const int cell_z = z / Step;
+    const float tx = static_cast<float>(x % Step) / Step;
+    const float tz = static_cast<float>(z % Step) / Step;
+
+    auto bilerp = [&](const float (&field)[Points][Points]) {
+        const float near = field[cell_x][cell_z] + (field[cell_x][cell_z + 1] - field[cell_x][cell_z]) * tz;
+        const float far = field[cell_x + 1][cell_z] + (field[cell_x + 1][cell_z + 1] - field[cell_x + 1][cell_z]) * tz;
+        return near + (far - near) * tx;
+    };
+
+    return {
+        classify_biome(bilerp(region.temperature), bilerp(region.humidity)),
+        bilerp(region.height_offset),
+        bilerp(region.height_scale)
+    };
+}
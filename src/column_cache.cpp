@@ -0,0 +1,53 @@
+#include <column_cache.hpp>
+
+ColumnCache::ColumnCache(const WorldGenerator& generator, int chunks_per_column, size_t capacity)
+    : generator{generator}, chunks_per_column{chunks_per_column}, capacity{capacity} {}
+
+std::shared_ptr<const ColumnFields> ColumnCache::get(ChunkPosition pos) {
+    std::shared_ptr<Column> column;
+    {
+        std::lock_guard lock{ mutex };
+
+        auto key = std::to_string(pos.x) + "," + std::to_string(pos.z);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            lru.splice(lru.begin(), lru, it->second.lru_position);
+            ++stats.hits;
+        } else {
+            lru.push_front(key);
+            it = entries.insert({ std::move(key), Entry{ std::make_shared<Column>(), lru.begin() } }).first;
+            ++stats.misses;
+        }
+
+        ++it->second.chunks_generated;
+        column = it->second.column;
+
+        if (entries.size() > capacity) {
+            evict();
+        }
+    }
+
+    // Noise is the expensive part, so it's computed outside the lock.
+    std::call_once(column->computed, [&] {
+        generator.get_column_fields(pos, column->fields);
+    });
+
+    // Aliases the column, keeping it alive even if it's evicted meanwhile.
+    return { column, &column->fields };
+}
+
+void ColumnCache::evict() {
+    // Least recently used column that's done, otherwise the least recently
+    // used one. The column just asked for is at the front and never evicted.
+    auto victim = std::prev(lru.end());
+    for (auto it = lru.rbegin(); it != std::prev(lru.rend()); ++it) {
+        if (entries.at(*it).chunks_generated >= chunks_per_column) {
+            victim = std::prev(it.base());
+            break;
+        }
+    }
+
+    entries.erase(*victim);
+    lru.erase(victim);
+    ++stats.evictions;
+}
@@ -0,0 +1,134 @@
+#include <decoration.hpp>
+
+#include <algorithm>
+
+namespace {
+    auto is_ore(VoxelType type) -> bool {
+        return type == VoxelType::ORE_COAL || type == VoxelType::ORE_IRON || type == VoxelType::ORE_GOLD;
+    }
+}
+
+auto get_spill_bit(ChunkPosition source, ChunkPosition target) -> uint16_t {
+    const int dx = source.x - target.x;
+    const int dz = source.z - target.z;
+    return static_cast<uint16_t>(1u << ((dx + 1) * 3 + dz + 1));
+}
+
+auto apply_feature_spill(Chunk& chunk, const FeatureSpill& spill) -> bool {
+    const auto bit = get_spill_bit(spill.source, spill.target);
+    if (chunk.spill_sources & bit) {
+        return false;
+    }
+    chunk.spill_sources |= bit;
+
+    bool changed = false;
+    for (const auto& voxel : spill.voxels) {
+        if (!chunk.is_snapshot && chunk.edited_voxels.contains(Chunk::get_voxel_index(voxel.x, voxel.y, voxel.z))) {
+            continue;
+        }
+
+        const auto current = chunk.voxels[voxel.x][voxel.y][voxel.z].type;
+        const bool replaces = current == voxel.replace
+            || (is_ore(current) && is_ore(voxel.type) && voxel.type > current);
+        if (replaces) {
+            chunk.set_generated_voxel(voxel.x, voxel.y, voxel.z, voxel.type);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void DecorationQueue::push(FeatureSpill spill) {
+    auto& shard = get_shard(spill.target);
+    {
+        std::lock_guard lock{ shard.mutex };
+
+        auto& entry = shard.entries[get_key(spill.target)];
+        entry.target = spill.target;
+
+        auto it = std::find_if(entry.spills.begin(), entry.spills.end(), [&](const FeatureSpill& queued) {
+            return queued.source == spill.source;
+        });
+        if (it != entry.spills.end()) {
+            *it = spill;
+        } else {
+            entry.spills.push_back(spill);
+        }
+
+        if (!entry.claimed) {
+            return;
+        }
+    }
+
+    std::lock_guard lock{ late_mutex };
+    late.push_back(std::move(spill));
+}
+
+auto DecorationQueue::claim(ChunkPosition pos) -> std::vector<FeatureSpill> {
+    auto& shard = get_shard(pos);
+    std::lock_guard lock{ shard.mutex };
+
+    auto& entry = shard.entries[get_key(pos)];
+    entry.target = pos;
+    entry.claimed = true;
+    return entry.spills;
+}
+
+void DecorationQueue::release(ChunkPosition pos) {
+    auto& shard = get_shard(pos);
+    std::lock_guard lock{ shard.mutex };
+
+    auto it = shard.entries.find(get_key(pos));
+    if (it != shard.entries.end()) {
+        it->second.claimed = false;
+    }
+}
+
+void DecorationQueue::evict(const std::function<bool(ChunkPosition)>& is_needed) {
+    for (auto& shard : shards) {
+        std::lock_guard lock{ shard.mutex };
+        std::erase_if(shard.entries, [&](const auto& entry) {
+            return !is_needed(entry.second.target);
+        });
+    }
+}
+
+void DecorationQueue::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard lock{ shard.mutex };
+        shard.entries.clear();
+    }
+
+    std::lock_guard lock{ late_mutex };
+    late.clear();
+}
+
+auto DecorationQueue::take_late() -> std::vector<FeatureSpill> {
+    std::vector<FeatureSpill> spills;
+    std::lock_guard lock{ late_mutex };
+    spills.swap(late);
+    return spills;
+}
+
+auto DecorationQueue::get_pending_count() const -> size_t {
+    size_t count = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock{ shard.mutex };
+        for (const auto& [key, entry] : shard.entries) {
+            for (const auto& spill : entry.spills) {
+                count += spill.voxels.size();
+            }
+        }
+    }
+    return count;
+}
+
+auto DecorationQueue::get_shard(ChunkPosition pos) -> Shard& {
+    const auto hash = static_cast<unsigned int>(pos.x) * 73856093u
+        ^ static_cast<unsigned int>(pos.y) * 19349663u ^ static_cast<unsigned int>(pos.z) * 83492791u;
+    return shards[hash % ShardCount];
+}
+
+auto DecorationQueue::get_key(ChunkPosition pos) -> std::string {
+    return std::to_string(pos.x) + "_" + std::to_string(pos.y) + "_" + std::to_string(pos.z);
+}
@@ -0,0 +1,391 @@
+#include <edit_journal.hpp>
+#include <world_gen.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <span>
+#include <cstddef>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    static_assert(sizeof (EditJournal::Record) == 20, "Journal records are written as is.");
+
+    constexpr size_t checksummed_size = offsetof(EditJournal::Record, checksum);
+
+    auto get_checksum(const EditJournal::Record& record) -> uint32_t {
+        // FNV-1a, torn writes are all we need to catch.
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&record);
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < checksummed_size; ++i) {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    auto sync_file(std::FILE* file) -> bool {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // New and deleted generation files are only durable once their
+    // directory entry is.
+    void sync_directory(const std::filesystem::path& directory) {
+#ifndef _WIN32
+        int fd = open(directory.c_str(), O_RDONLY);
+        if (fd >= 0) {
+            fsync(fd);
+            close(fd);
+        }
+#else
+        (void)directory;
+#endif
+    }
+
+    auto parse_generation(const std::filesystem::path& path, uint64_t& generation) -> bool {
+        // journal.N.bin
+        auto name = path.filename().string();
+        if (!name.starts_with("journal.") || !name.ends_with(".bin")) {
+            return false;
+        }
+
+        auto number = name.substr(8, name.size() - 12);
+        if (number.empty() || !std::all_of(number.begin(), number.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return false;
+        }
+
+        generation = std::stoull(number);
+        return true;
+    }
+}
+
+EditJournal::EditJournal(std::filesystem::path directory)
+    : EditJournal(std::move(directory), Settings{}) {}
+
+EditJournal::EditJournal(std::filesystem::path directory, Settings settings)
+    : directory{std::move(directory)}, settings{settings} {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(this->directory, ec)) {
+        uint64_t found;
+        if (parse_generation(entry.path(), found)) {
+            leftover_generations.push_back(found);
+        }
+    }
+    std::sort(leftover_generations.begin(), leftover_generations.end());
+
+    // Never append to an old generation, its tail may be torn.
+    generation = leftover_generations.empty() ? 1 : leftover_generations.back() + 1;
+    file = open_generation(generation);
+    opened = file != nullptr;
+    generation_start = std::chrono::steady_clock::now();
+
+    commit_thread = std::jthread{ [this](std::stop_token stop) { commit_loop(stop); } };
+}
+
+EditJournal::~EditJournal() {
+    commit();
+
+    commit_thread.request_stop();
+    condition.notify_all();
+    commit_thread.join();
+
+    if (next_file) std::fclose(next_file);
+    if (file) std::fclose(file);
+}
+
+bool EditJournal::is_open() const {
+    return opened;
+}
+
+void EditJournal::append(Position pos, VoxelType type) {
+    Record record = {};
+    record.x = pos.x;
+    record.y = pos.y;
+    record.z = pos.z;
+    record.type = static_cast<uint8_t>(type);
+    record.checksum = get_checksum(record);
+
+    {
+        std::lock_guard lock{ mutex };
+        pending.push_back(record);
+        ++appended;
+        generation_bytes += sizeof (Record);
+    }
+    ++stats.records;
+}
+
+void EditJournal::commit() {
+    std::unique_lock lock{ mutex };
+    const uint64_t target = appended;
+    commit_requested = true;
+    condition.notify_all();
+    condition.wait(lock, [&] { return committed >= target; });
+}
+
+size_t EditJournal::replay(RegionStorage& storage) {
+    // Edits are grouped per chunk, in journal order, so each chunk is loaded
+    // and saved once.
+    std::vector<std::pair<ChunkPosition, std::vector<Record>>> chunks;
+    std::unordered_map<std::string, size_t> chunk_indices;
+    size_t count = 0;
+
+    for (auto old_generation : leftover_generations) {
+        auto path = get_generation_path(old_generation);
+        std::FILE* in = std::fopen(path.string().c_str(), "rb");
+        if (!in) {
+            continue;
+        }
+
+        Record record;
+        while (std::fread(&record, sizeof record, 1, in) == 1) {
+            // Anything after a bad record was never committed.
+            if (record.checksum != get_checksum(record)) break;
+
+            auto pos = ChunkPosition::from_world_pos(Position{ record.x, record.y, record.z });
+            auto key = std::to_string(pos.x) + "_" + std::to_string(pos.y) + "_" + std::to_string(pos.z);
+            auto [it, inserted] = chunk_indices.insert({ key, chunks.size() });
+            if (inserted) {
+                chunks.push_back({ pos, {} });
+            }
+
+            chunks[it->second].second.push_back(record);
+            ++count;
+        }
+
+        std::fclose(in);
+    }
+
+    bool saved = true;
+    auto chunk = std::make_unique<Chunk>();
+    for (const auto& [pos, records] : chunks) {
+        *chunk = Chunk{};
+        chunk->position = pos;
+        if (!storage.load_chunk(*chunk)) {
+            chunk->fill(VoxelType::NONE);
+            populate_chunk(*chunk);
+        }
+
+        for (const auto& record : records) {
+            chunk->set_voxel(
+                record.x - pos.x * Chunk::Width,
+                record.y - pos.y * Chunk::Height,
+                record.z - pos.z * Chunk::Width, static_cast<VoxelType>(record.type));
+        }
+
+        saved = storage.save_chunk(*chunk) && saved;
+    }
+
+    for (auto* region : storage.get_regions()) {
+        saved = region->sync() && saved;
+    }
+
+    if (!saved) {
+        std::cerr << "Failed to write replayed edits to region files, keeping the journal.\n";
+        return count;
+    }
+
+    std::error_code ec;
+    for (auto old_generation : leftover_generations) {
+        std::filesystem::remove(get_generation_path(old_generation), ec);
+    }
+    sync_directory(directory);
+    leftover_generations.clear();
+
+    return count;
+}
+
+bool EditJournal::is_checkpoint_due() const {
+    if (checkpointing) {
+        return false;
+    }
+
+    std::lock_guard lock{ mutex };
+    if (generation_bytes >= settings.checkpoint_bytes) {
+        return true;
+    }
+
+    return generation_bytes > 0
+        && std::chrono::steady_clock::now() - generation_start >= settings.checkpoint_interval;
+}
+
+void EditJournal::begin_checkpoint() {
+    std::lock_guard lock{ mutex };
+    if (checkpointing) {
+        return;
+    }
+
+    std::FILE* created = open_generation(generation + 1);
+    if (!created) {
+        return;
+    }
+
+    sealed_generations.push_back(generation);
+    ++generation;
+    generation_start = std::chrono::steady_clock::now();
+    generation_bytes = 0;
+
+    next_file = created;
+    rotate_split = pending.size();
+    rotate_requested = true;
+    checkpointing = true;
+}
+
+void EditJournal::finish_checkpoint(std::vector<RegionFile*> files) {
+    {
+        std::lock_guard lock{ mutex };
+        if (!checkpointing) {
+            return;
+        }
+
+        checkpoint_files = std::move(files);
+        checkpoint_ready = true;
+    }
+    condition.notify_all();
+}
+
+void EditJournal::abandon_checkpoint() {
+    // The sealed generations stay listed, so the next checkpoint that succeeds
+    // deletes them too. Deleting only the newer ones would have `replay()`
+    // apply the old edits over the checkpointed values.
+    std::lock_guard lock{ mutex };
+    checkpointing = false;
+}
+
+void EditJournal::commit_loop(std::stop_token stop) {
+    while (true) {
+        std::vector<Record> batch;
+        uint64_t target;
+        std::FILE* rotate_to = nullptr;
+        size_t split = 0;
+        std::vector<RegionFile*> files;
+        std::vector<uint64_t> sealed;
+        bool checkpoint = false;
+
+        {
+            std::unique_lock lock{ mutex };
+            condition.wait_for(lock, stop, settings.commit_interval,
+                [this] { return commit_requested || checkpoint_ready; });
+
+            batch.swap(pending);
+            target = appended;
+            commit_requested = false;
+
+            if (rotate_requested) {
+                rotate_to = std::exchange(next_file, nullptr);
+                split = rotate_split;
+                rotate_requested = false;
+            }
+
+            if (checkpoint_ready) {
+                files = std::move(checkpoint_files);
+                if (!retaining) {
+                    sealed = std::exchange(sealed_generations, {});
+                }
+                checkpoint = true;
+                checkpoint_ready = false;
+            }
+        }
+
+        bool written = true;
+        if (rotate_to) {
+            written = write_records(file, { batch.data(), split });
+            if (file) std::fclose(file);
+
+            file = rotate_to;
+            written = write_records(file, { batch.data() + split, batch.size() - split }) && written;
+            sync_directory(directory);
+        } else {
+            written = write_records(file, batch);
+        }
+
+        if (!written) {
+            std::cerr << "Failed to write " << batch.size() << " edits to the journal.\n";
+        }
+
+        {
+            std::lock_guard lock{ mutex };
+            committed = target;
+        }
+        if (!batch.empty()) {
+            ++stats.commits;
+        }
+        condition.notify_all();
+
+        if (checkpoint) {
+            bool synced = true;
+            for (auto* region : files) {
+                synced = region->sync() && synced;
+            }
+
+            if (synced) {
+                std::error_code ec;
+                for (auto old_generation : sealed) {
+                    std::filesystem::remove(get_generation_path(old_generation), ec);
+                }
+                sync_directory(directory);
+                ++stats.checkpoints;
+            } else {
+                // The region files may have lost any write since the last
+                // checkpoint, so from now on every generation is kept and the
+                // next start replays all of them in order.
+                std::cerr << "Failed to sync region files, keeping the journal until the next start.\n";
+                std::lock_guard lock{ mutex };
+                sealed_generations.insert(sealed_generations.begin(), sealed.begin(), sealed.end());
+                retaining = true;
+            }
+
+            checkpointing = false;
+        }
+
+        if (stop.stop_requested()) {
+            std::lock_guard lock{ mutex };
+            if (pending.empty() && !rotate_requested && !checkpoint_ready) {
+                return;
+            }
+        }
+    }
+}
+
+bool EditJournal::write_records(std::FILE* out, std::span<const Record> records) {
+    if (records.empty()) {
+        return true;
+    }
+
+    if (!out) {
+        return false;
+    }
+
+    if (std::fwrite(records.data(), sizeof (Record), records.size(), out) != records.size()) {
+        return false;
+    }
+
+    return sync_file(out);
+}
+
+std::filesystem::path EditJournal::get_generation_path(uint64_t generation) const {
+    return directory / ("journal." + std::to_string(generation) + ".bin");
+}
+
+std::FILE* EditJournal::open_generation(uint64_t generation) {
+    auto path = get_generation_path(generation);
+    std::FILE* opened = std::fopen(path.string().c_str(), "wb");
+    if (!opened) {
+        std::cerr << "Failed to open edit journal " << path.string() << ".\n";
+    }
+    return opened;
+}
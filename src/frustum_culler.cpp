@@ -0,0 +1,195 @@
+#include <frustum_culler.hpp>
+#include <noise_lanes.hpp>
+
+#include <algorithm>
+
+auto Frustum::from_matrix(const glm::mat4& view_projection) -> Frustum {
+    // glm is column major, m[column][row].
+    const auto& m = view_projection;
+    auto row = [&m](int i) { return glm::vec4{ m[0][i], m[1][i], m[2][i], m[3][i] }; };
+
+    Frustum frustum;
+    frustum.planes[0] = row(3) + row(0); // left
+    frustum.planes[1] = row(3) - row(0); // right
+    frustum.planes[2] = row(3) + row(1); // bottom
+    frustum.planes[3] = row(3) - row(1); // top
+    frustum.planes[4] = row(3) + row(2); // near
+    frustum.planes[5] = row(3) - row(2); // far
+    return frustum;
+}
+
+auto Frustum::intersects(const glm::vec3& min, const glm::vec3& max) const -> bool {
+    for (const auto& plane : planes) {
+        const glm::vec3 far{
+            (plane.x > 0.0f) ? max.x : min.x,
+            (plane.y > 0.0f) ? max.y : min.y,
+            (plane.z > 0.0f) ? max.z : min.z
+        };
+        if (plane.x * far.x + plane.y * far.y + plane.z * far.z + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ChunkCuller::Boxes::resize(size_t size) {
+    using Ops = NoiseLanes::SimdOps;
+    const size_t padded = (size + Ops::Lanes - 1) / Ops::Lanes * Ops::Lanes;
+    for (auto* lanes : { &min_x, &min_y, &min_z, &max_x, &max_y, &max_z }) {
+        lanes->resize(padded);
+    }
+}
+
+void ChunkCuller::Boxes::set(size_t index, const glm::vec3& min, const glm::vec3& max) {
+    min_x[index] = min.x;
+    min_y[index] = min.y;
+    min_z[index] = min.z;
+    max_x[index] = max.x;
+    max_y[index] = max.y;
+    max_z[index] = max.z;
+}
+
+void ChunkCuller::insert(ChunkPosition pos, const glm::vec3& min, const glm::vec3& max) {
+    auto& cell = cells[get_cell_key(pos)];
+
+    auto it = std::find(cell.positions.begin(), cell.positions.end(), pos);
+    const auto index = static_cast<size_t>(it - cell.positions.begin());
+    if (it == cell.positions.end()) {
+        cell.positions.push_back(pos);
+        cell.boxes.resize(cell.positions.size());
+        ++count;
+    }
+
+    cell.boxes.set(index, min, max);
+    update_bounds(cell);
+}
+
+void ChunkCuller::erase(ChunkPosition pos) {
+    auto cell_it = cells.find(get_cell_key(pos));
+    if (cell_it == cells.end()) {
+        return;
+    }
+
+    auto& cell = cell_it->second;
+    auto it = std::find(cell.positions.begin(), cell.positions.end(), pos);
+    if (it == cell.positions.end()) {
+        return;
+    }
+    --count;
+
+    if (cell.positions.size() == 1) {
+        cells.erase(cell_it);
+        return;
+    }
+
+    // Swap in the last box, order doesn't matter.
+    const auto index = static_cast<size_t>(it - cell.positions.begin());
+    const auto last = cell.positions.size() - 1;
+    cell.positions[index] = cell.positions[last];
+    cell.boxes.set(index,
+        { cell.boxes.min_x[last], cell.boxes.min_y[last], cell.boxes.min_z[last] },
+        { cell.boxes.max_x[last], cell.boxes.max_y[last], cell.boxes.max_z[last] });
+    cell.positions.pop_back();
+    cell.boxes.resize(last);
+    update_bounds(cell);
+}
+
+void ChunkCuller::clear() {
+    cells.clear();
+    count = 0;
+}
+
+void ChunkCuller::cull(const Frustum& frustum, std::vector<ChunkPosition>& visible) const {
+    static thread_local Boxes cell_boxes;
+    static thread_local std::vector<const Cell*> cell_list;
+    static thread_local std::vector<Containment> cell_results;
+    static thread_local std::vector<Containment> chunk_results;
+
+    cell_list.clear();
+    cell_boxes.resize(cells.size());
+    for (const auto& [key, cell] : cells) {
+        cell_boxes.set(cell_list.size(), cell.min, cell.max);
+        cell_list.push_back(&cell);
+    }
+
+    test_boxes(frustum, cell_boxes, cell_list.size(), cell_results);
+
+    for (size_t i = 0; i < cell_list.size(); ++i) {
+        const Cell& cell = *cell_list[i];
+        switch (cell_results[i]) {
+            case Containment::OUTSIDE:
+                break;
+
+            case Containment::INSIDE:
+                visible.insert(visible.end(), cell.positions.begin(), cell.positions.end());
+                break;
+
+            case Containment::CROSSING:
+                test_boxes(frustum, cell.boxes, cell.positions.size(), chunk_results);
+                for (size_t j = 0; j < cell.positions.size(); ++j) {
+                    if (chunk_results[j] != Containment::OUTSIDE) {
+                        visible.push_back(cell.positions[j]);
+                    }
+                }
+                break;
+        }
+    }
+}
+
+void ChunkCuller::test_boxes(const Frustum& frustum, const Boxes& boxes, size_t size,
+    std::vector<Containment>& out) {
+    using Ops = NoiseLanes::SimdOps;
+    out.resize(size);
+
+    const auto zero = Ops::set(0.0f);
+    for (size_t i = 0; i < size; i += Ops::Lanes) {
+        int outside = 0;
+        int crossing = 0;
+
+        for (const auto& plane : frustum.planes) {
+            // The corner furthest along the plane's normal is the last one
+            // to leave its inner side, the nearest corner the first.
+            const float* far_x = (plane.x > 0.0f) ? &boxes.max_x[i] : &boxes.min_x[i];
+            const float* far_y = (plane.y > 0.0f) ? &boxes.max_y[i] : &boxes.min_y[i];
+            const float* far_z = (plane.z > 0.0f) ? &boxes.max_z[i] : &boxes.min_z[i];
+            const float* near_x = (plane.x > 0.0f) ? &boxes.min_x[i] : &boxes.max_x[i];
+            const float* near_y = (plane.y > 0.0f) ? &boxes.min_y[i] : &boxes.max_y[i];
+            const float* near_z = (plane.z > 0.0f) ? &boxes.min_z[i] : &boxes.max_z[i];
+
+            const auto a = Ops::set(plane.x);
+            const auto b = Ops::set(plane.y);
+            const auto c = Ops::set(plane.z);
+            const auto d = Ops::set(plane.w);
+            auto distance = [&](const float* x, const float* y, const float* z) {
+                return Ops::add(Ops::add(Ops::mul(a, Ops::load(x)), Ops::mul(b, Ops::load(y))),
+                    Ops::add(Ops::mul(c, Ops::load(z)), d));
+            };
+
+            outside |= Ops::to_bits(Ops::less(distance(far_x, far_y, far_z), zero));
+            crossing |= Ops::to_bits(Ops::less(distance(near_x, near_y, near_z), zero));
+        }
+
+        const size_t lanes = std::min<size_t>(Ops::Lanes, size - i);
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            out[i + lane] = ((outside >> lane) & 1) ? Containment::OUTSIDE
+                : ((crossing >> lane) & 1) ? Containment::CROSSING : Containment::INSIDE;
+        }
+    }
+}
+
+void ChunkCuller::update_bounds(Cell& cell) {
+    const auto& boxes = cell.boxes;
+    const size_t size = cell.positions.size();
+    cell.min = { boxes.min_x[0], boxes.min_y[0], boxes.min_z[0] };
+    cell.max = { boxes.max_x[0], boxes.max_y[0], boxes.max_z[0] };
+    for (size_t i = 1; i < size; ++i) {
+        cell.min = glm::min(cell.min, glm::vec3{ boxes.min_x[i], boxes.min_y[i], boxes.min_z[i] });
+        cell.max = glm::max(cell.max, glm::vec3{ boxes.max_x[i], boxes.max_y[i], boxes.max_z[i] });
+    }
+}
+
+auto ChunkCuller::get_cell_key(ChunkPosition pos) -> int64_t {
+    // Round towards negative infinity, so cells don't straddle 0.
+    auto cell = [](int v) { return (v >= 0 ? v : v - CellWidth + 1) / CellWidth; };
+    return (static_cast<int64_t>(cell(pos.x)) << 32) | static_cast<uint32_t>(cell(pos.z));
+}
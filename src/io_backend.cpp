@@ -0,0 +1,279 @@
+#include <io_backend.hpp>
+#include <thread_pool.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <cerrno>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define FE_HAS_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Blocking pread/pwrite on pool threads. Portable, and plenty for SATA
+    // drives, but every op costs a context switch.
+    class ThreadPoolIoBackend : public IoBackend {
+    public:
+        explicit ThreadPoolIoBackend(unsigned int queue_depth)
+            : queue_depth{queue_depth}, pool{ std::min(queue_depth, 8u) } {}
+
+        auto get_name() const -> const char* override {
+            return "thread pool";
+        }
+
+        auto get_queue_depth() const -> unsigned int override {
+            return queue_depth;
+        }
+
+        void submit(std::span<const IoOp> ops) override {
+            for (const auto& op : ops) {
+                pool.submit([this, op] {
+                    bool success = (op.type == IoOp::Type::READ)
+                        ? op.file->read_at(op.offset, op.buffer, op.length)
+                        : op.file->write_at(op.offset, op.buffer, op.length);
+
+                    std::lock_guard lock{ mutex };
+                    completed.push_back({ op.user_data, success });
+                });
+            }
+        }
+
+        void poll(std::vector<IoResult>& out) override {
+            std::lock_guard lock{ mutex };
+            out.insert(out.end(), completed.begin(), completed.end());
+            completed.clear();
+        }
+
+    private:
+        unsigned int queue_depth;
+
+        std::mutex mutex;
+        std::vector<IoResult> completed;
+
+        // Last, so workers stop before the completion list goes away.
+        ThreadPool pool;
+    };
+
+#ifdef FE_HAS_IO_URING
+    // io_uring through raw syscalls, so there's no liburing dependency. One
+    // ring, no SQ polling thread: `submit()` fills SQEs for the whole batch
+    // and enters the kernel once.
+    class IoUringBackend : public IoBackend {
+    public:
+        ~IoUringBackend() override {
+            if (sqes) munmap(sqes, sqes_size);
+            if (cq_ptr && cq_ptr != sq_ptr) munmap(cq_ptr, cq_ring_size);
+            if (sq_ptr) munmap(sq_ptr, sq_ring_size);
+            if (ring_fd >= 0) close(ring_fd);
+        }
+
+        auto init(unsigned int depth) -> bool {
+            io_uring_params params = {};
+            ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+            if (ring_fd < 0) {
+                return false;
+            }
+
+            // IORING_OP_READ/WRITE need 5.6, which is also when this flag appeared.
+            if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+                return false;
+            }
+
+            queue_depth = params.sq_entries;
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+                cq_ring_size = sq_ring_size;
+            }
+
+            sq_ptr = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd, IORING_OFF_SQ_RING);
+            if (sq_ptr == MAP_FAILED) {
+                sq_ptr = nullptr;
+                return false;
+            }
+
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                cq_ptr = sq_ptr;
+            } else {
+                cq_ptr = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd, IORING_OFF_CQ_RING);
+                if (cq_ptr == MAP_FAILED) {
+                    cq_ptr = nullptr;
+                    return false;
+                }
+            }
+
+            sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+            void* sqes_ptr = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd, IORING_OFF_SQES);
+            if (sqes_ptr == MAP_FAILED) {
+                return false;
+            }
+            sqes = static_cast<io_uring_sqe*>(sqes_ptr);
+
+            auto* sq = static_cast<uint8_t*>(sq_ptr);
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+            auto* cq = static_cast<uint8_t*>(cq_ptr);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+            // One slot per possible in-flight op; the SQE user_data is the slot index.
+            slots.resize(queue_depth);
+            free_slots.reserve(queue_depth);
+            for (unsigned int i = queue_depth; i > 0; --i) {
+                free_slots.push_back(i - 1);
+            }
+
+            return true;
+        }
+
+        auto get_name() const -> const char* override {
+            return "io_uring";
+        }
+
+        auto get_queue_depth() const -> unsigned int override {
+            return queue_depth;
+        }
+
+        void submit(std::span<const IoOp> ops) override {
+            for (const auto& op : ops) {
+                unsigned int slot = free_slots.back();
+                free_slots.pop_back();
+
+                slots[slot] = { op, 0 };
+                push_sqe(slot);
+            }
+            enter();
+        }
+
+        void poll(std::vector<IoResult>& out) override {
+            std::atomic_ref<unsigned> tail_ref{ *cq_tail };
+            std::atomic_ref<unsigned> head_ref{ *cq_head };
+
+            unsigned head = head_ref.load(std::memory_order_relaxed);
+            const unsigned tail = tail_ref.load(std::memory_order_acquire);
+            bool resubmitted = false;
+
+            while (head != tail) {
+                const io_uring_cqe& cqe = cqes[head & cq_mask];
+                ++head;
+
+                const auto slot = static_cast<unsigned int>(cqe.user_data);
+                auto& state = slots[slot];
+
+                if (cqe.res > 0 && state.done + static_cast<uint32_t>(cqe.res) < state.op.length) {
+                    // Short transfer, queue the remainder.
+                    state.done += static_cast<uint32_t>(cqe.res);
+                    push_sqe(slot);
+                    resubmitted = true;
+                    continue;
+                }
+
+                const bool success = cqe.res > 0 && state.done + static_cast<uint32_t>(cqe.res) == state.op.length;
+                out.push_back({ state.op.user_data, success });
+                free_slots.push_back(slot);
+            }
+
+            head_ref.store(head, std::memory_order_release);
+
+            if (resubmitted) {
+                enter();
+            }
+        }
+
+    private:
+        struct Slot {
+            IoOp op;
+            uint32_t done;
+        };
+
+        void push_sqe(unsigned int slot) {
+            const auto& state = slots[slot];
+
+            std::atomic_ref<unsigned> tail_ref{ *sq_tail };
+            const unsigned tail = tail_ref.load(std::memory_order_relaxed);
+            const unsigned index = tail & sq_mask;
+
+            io_uring_sqe& sqe = sqes[index];
+            sqe = {};
+            sqe.opcode = (state.op.type == IoOp::Type::READ) ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe.fd = state.op.file->get_fd();
+            sqe.off = state.op.offset + state.done;
+            sqe.addr = reinterpret_cast<uint64_t>(state.op.buffer + state.done);
+            sqe.len = state.op.length - state.done;
+            sqe.user_data = slot;
+
+            sq_array[index] = index;
+            tail_ref.store(tail + 1, std::memory_order_release);
+            ++unsubmitted;
+        }
+
+        void enter() {
+            while (unsubmitted > 0) {
+                long submitted = syscall(__NR_io_uring_enter, ring_fd, unsubmitted, 0, 0, nullptr, 0);
+                if (submitted < 0) {
+                    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+
+                    std::cerr << "io_uring_enter failed: errno " << errno << "\n";
+                    return;
+                }
+                unsubmitted -= static_cast<unsigned int>(submitted);
+            }
+        }
+
+        int ring_fd = -1;
+        unsigned int queue_depth = 0;
+        unsigned int unsubmitted = 0;
+
+        void* sq_ptr = nullptr;
+        void* cq_ptr = nullptr;
+        size_t sq_ring_size = 0;
+        size_t cq_ring_size = 0;
+
+        io_uring_sqe* sqes = nullptr;
+        size_t sqes_size = 0;
+
+        unsigned* sq_tail = nullptr;
+        unsigned sq_mask = 0;
+        unsigned* sq_array = nullptr;
+
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        io_uring_cqe* cqes = nullptr;
+
+        std::vector<Slot> slots;
+        std::vector<unsigned int> free_slots;
+    };
+#endif
+}
+
+std::unique_ptr<IoBackend> create_thread_pool_io_backend(unsigned int queue_depth) {
+    return std::make_unique<ThreadPoolIoBackend>(queue_depth);
+}
+
+std::unique_ptr<IoBackend> create_io_backend(unsigned int queue_depth) {
+#ifdef FE_HAS_IO_URING
+    // Fails on old kernels and in sandboxes that block io_uring via seccomp.
+    auto uring = std::make_unique<IoUringBackend>();
+    if (uring->init(queue_depth)) {
+        return uring;
+    }
+#endif
+
+    return create_thread_pool_io_backend(queue_depth);
+}
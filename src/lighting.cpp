@@ -0,0 +1,416 @@
+#include <lighting.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace {
+    // How far into the neighbours light can start and still reach the chunk.
+    constexpr int Margin = Chunk::MaxLight - 1;
+
+    // Width of the region around the chunk that's flooded.
+    constexpr int Padded = Chunk::Width + 2 * Margin;
+
+    // The chunk and its neighbours, in region coordinates: the chunk starts
+    // at (Margin, Margin).
+    struct LightRegion {
+        const Chunk* chunks[3][3];
+        int16_t heights[Padded][Padded];
+
+        // Every voxel at or above this is sky.
+        int top = 0;
+
+        auto get_chunk(int px, int pz, int& local_x, int& local_z) const -> const Chunk* {
+            const int x = px - Margin + Chunk::Width;
+            const int z = pz - Margin + Chunk::Width;
+            local_x = x % Chunk::Width;
+            local_z = z % Chunk::Width;
+            return chunks[x / Chunk::Width][z / Chunk::Width];
+        }
+
+        // Missing chunks count as solid.
+        auto is_air(int px, int y, int pz) const -> bool {
+            int x, z;
+            const Chunk* chunk = get_chunk(px, pz, x, z);
+            return chunk && chunk->voxels[x][y][z].type == VoxelType::NONE;
+        }
+    };
+}
+
+LightSnapshot LightSnapshot::pin(const World& world, ChunkPosition pos) {
+    LightSnapshot snapshot;
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            snapshot.chunks[dx + 1][dz + 1] = world.pin_chunk(pos + ChunkPosition{ dx, 0, dz });
+        }
+    }
+    return snapshot;
+}
+
+void compute_skylight(const LightSnapshot& snapshot, Chunk::LightLevels& out) {
+    LightRegion region;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            region.chunks[i][j] = snapshot.chunks[i][j].get();
+        }
+    }
+
+    for (int px = 0; px < Padded; ++px) {
+        for (int pz = 0; pz < Padded; ++pz) {
+            int x, z;
+            const Chunk* chunk = region.get_chunk(px, pz, x, z);
+
+            // Nothing enters a missing chunk, as if it was solid to the top.
+            const int height = chunk ? chunk->heightmap[x][z] : Chunk::Height;
+            region.heights[px][pz] = static_cast<int16_t>(height);
+            region.top = std::max(region.top, height);
+        }
+    }
+
+    // Levels of the voxels below the sky, indexed [x][y][z] up to `top`.
+    // Reused between calls, most of the cost is clearing it.
+    const int top = region.top;
+    static thread_local std::vector<uint8_t> light;
+    light.assign(static_cast<size_t>(Padded) * top * Padded, 0);
+
+    auto at = [top](int px, int y, int pz) {
+        return static_cast<uint32_t>((px * top + y) * Padded + pz);
+    };
+
+    static thread_local std::vector<uint32_t> queue;
+    queue.clear();
+
+    static constexpr int offsets[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+
+    // Seeds: air under a taller neighbour, next to sky. Sky never has dark
+    // air right below it, the heightmap stops at the first solid voxel.
+    for (int px = 0; px < Padded; ++px) {
+        for (int pz = 0; pz < Padded; ++pz) {
+            const int height = region.heights[px][pz];
+
+            for (const auto& [dx, dz] : offsets) {
+                const int nx = px + dx;
+                const int nz = pz + dz;
+                if (nx < 0 || nx >= Padded || nz < 0 || nz >= Padded) continue;
+
+                for (int y = height; y < region.heights[nx][nz]; ++y) {
+                    if (!region.is_air(nx, y, nz)) continue;
+
+                    auto& level = light[at(nx, y, nz)];
+                    if (level == 0) {
+                        level = Chunk::MaxLight - 1;
+                        queue.push_back(at(nx, y, nz));
+                    }
+                }
+            }
+        }
+    }
+
+    // Every seed has the same level, so first come is brightest and each
+    // voxel is queued at most once.
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const uint32_t index = queue[head];
+        const int pz = static_cast<int>(index % Padded);
+        const int y = static_cast<int>(index / Padded % top);
+        const int px = static_cast<int>(index / Padded / top);
+
+        const uint8_t next = light[index] - 1;
+        if (next == 0) continue;
+
+        auto spread = [&](int nx, int ny, int nz) {
+            if (nx < 0 || nx >= Padded || nz < 0 || nz >= Padded || ny < 0) return;
+            if (ny >= region.heights[nx][nz]) return;
+
+            auto& level = light[at(nx, ny, nz)];
+            if (level >= next || !region.is_air(nx, ny, nz)) return;
+
+            level = next;
+            queue.push_back(at(nx, ny, nz));
+        };
+
+        spread(px - 1, y, pz);
+        spread(px + 1, y, pz);
+        spread(px, y - 1, pz);
+        spread(px, y + 1, pz);
+        spread(px, y, pz - 1);
+        spread(px, y, pz + 1);
+    }
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int z = 0; z < Chunk::Width; z += 2) {
+            const int px = x + Margin;
+            const int pz = z + Margin;
+            const int height_low = region.heights[px][pz];
+            const int height_high = region.heights[px][pz + 1];
+
+            for (int y = 0; y < Chunk::Height; ++y) {
+                const uint8_t low = (y >= height_low) ? Chunk::MaxLight : light[at(px, y, pz)];
+                const uint8_t high = (y >= height_high) ? Chunk::MaxLight : light[at(px, y, pz + 1)];
+                out.data[x][y][z / 2] = static_cast<uint8_t>(low | (high << 4));
+            }
+        }
+    }
+}
+
+void compute_blocklight(const LightSnapshot& snapshot, Chunk::LightLevels& out) {
+    LightRegion region;
+    bool any_emitters = false;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            region.chunks[i][j] = snapshot.chunks[i][j].get();
+            any_emitters |= region.chunks[i][j] && region.chunks[i][j]->emitter_count > 0;
+        }
+    }
+
+    std::fill_n(&out.data[0][0][0], sizeof out.data, 0);
+    if (!any_emitters) {
+        return;
+    }
+
+    static thread_local std::vector<uint8_t> light;
+    light.assign(static_cast<size_t>(Padded) * Chunk::Height * Padded, 0);
+
+    auto at = [](int px, int y, int pz) {
+        return static_cast<uint32_t>((px * Chunk::Height + y) * Padded + pz);
+    };
+
+    static thread_local std::vector<uint32_t> queue;
+    queue.clear();
+
+    for (int px = 0; px < Padded; ++px) {
+        for (int pz = 0; pz < Padded; ++pz) {
+            int x, z;
+            const Chunk* chunk = region.get_chunk(px, pz, x, z);
+            if (chunk == nullptr || chunk->emitter_count == 0) continue;
+
+            for (int y = 0; y < Chunk::Height; ++y) {
+                const uint8_t emission = get_light_emission(chunk->voxels[x][y][z].type);
+                if (emission > 0) {
+                    light[at(px, y, pz)] = emission;
+                    queue.push_back(at(px, y, pz));
+                }
+            }
+        }
+    }
+
+    // Emitters differ in brightness, so a voxel can be queued again when
+    // brighter light reaches it later.
+    for (size_t head = 0; head < queue.size(); ++head) {
+        const uint32_t index = queue[head];
+        const int pz = static_cast<int>(index % Padded);
+        const int y = static_cast<int>(index / Padded % Chunk::Height);
+        const int px = static_cast<int>(index / Padded / Chunk::Height);
+
+        const uint8_t next = light[index] - 1;
+        if (next == 0) continue;
+
+        auto spread = [&](int nx, int ny, int nz) {
+            if (nx < 0 || nx >= Padded || nz < 0 || nz >= Padded || ny < 0 || ny >= Chunk::Height) return;
+
+            auto& level = light[at(nx, ny, nz)];
+            if (level >= next || !region.is_air(nx, ny, nz)) return;
+
+            level = next;
+            queue.push_back(at(nx, ny, nz));
+        };
+
+        spread(px - 1, y, pz);
+        spread(px + 1, y, pz);
+        spread(px, y - 1, pz);
+        spread(px, y + 1, pz);
+        spread(px, y, pz - 1);
+        spread(px, y, pz + 1);
+    }
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int y = 0; y < Chunk::Height; ++y) {
+            for (int z = 0; z < Chunk::Width; ++z) {
+                out.set(x, y, z, light[at(x + Margin, y, z + Margin)]);
+            }
+        }
+    }
+}
+
+LightEditor::LightEditor(World& world, ChunkPosition pos)
+    : world{ world }, position{ pos } {
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            chunks[dx + 1][dz + 1] = world.get_chunk_at(pos + ChunkPosition{ dx, 0, dz });
+        }
+    }
+}
+
+void LightEditor::update(int x, int y, int z, VoxelType old_type) {
+    const int px = x + Chunk::Width;
+    const int pz = z + Chunk::Width;
+
+    int local_x, local_z;
+    const VoxelType type = get_chunk(px, pz, local_x, local_z)->voxels[x][y][z].type;
+    if (type == old_type) {
+        return;
+    }
+    const bool air = type == VoxelType::NONE;
+
+    for (const auto channel : { Channel::SKY, Channel::BLOCK }) {
+        removals.clear();
+        increases.clear();
+
+        // Whatever lit the voxel before may not anymore.
+        const uint8_t old_level = get_level(channel, px, y, pz);
+        if (old_level > 0) {
+            set_level(channel, px, y, pz, 0);
+            removals.push_back({ static_cast<int16_t>(px), static_cast<int16_t>(y), static_cast<int16_t>(pz), old_level });
+            remove(channel);
+        }
+
+        // Light the voxel makes by itself: emitters, and air with nothing
+        // above it.
+        uint8_t own = 0;
+        if (channel == Channel::BLOCK) {
+            own = get_light_emission(type);
+        } else if (air && y == Chunk::Height - 1) {
+            own = Chunk::MaxLight;
+        }
+        if (own > get_level(channel, px, y, pz)) {
+            set_level(channel, px, y, pz, own);
+            increases.push_back({ static_cast<int16_t>(px), static_cast<int16_t>(y), static_cast<int16_t>(pz), own });
+        }
+
+        // Opened up, so the light around flows in.
+        if (air) {
+            static constexpr int offsets[6][3] = {
+                { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }
+            };
+            for (const auto& [dx, dy, dz] : offsets) {
+                const uint8_t level = get_level(channel, px + dx, y + dy, pz + dz);
+                if (level > 0) {
+                    increases.push_back({ static_cast<int16_t>(px + dx), static_cast<int16_t>(y + dy), static_cast<int16_t>(pz + dz), level });
+                }
+            }
+        }
+
+        spread(channel);
+    }
+}
+
+auto LightEditor::get_chunk(int px, int pz, int& x, int& z) const -> Chunk* {
+    x = px % Chunk::Width;
+    z = pz % Chunk::Width;
+    return chunks[px / Chunk::Width][pz / Chunk::Width];
+}
+
+auto LightEditor::is_air(int px, int y, int pz) const -> bool {
+    if (px < 0 || px >= 3 * Chunk::Width || pz < 0 || pz >= 3 * Chunk::Width || y < 0 || y >= Chunk::Height) {
+        return false;
+    }
+
+    int x, z;
+    const Chunk* chunk = get_chunk(px, pz, x, z);
+    return chunk && chunk->voxels[x][y][z].type == VoxelType::NONE;
+}
+
+auto LightEditor::get_level(Channel channel, int px, int y, int pz) const -> uint8_t {
+    if (px < 0 || px >= 3 * Chunk::Width || pz < 0 || pz >= 3 * Chunk::Width || y < 0 || y >= Chunk::Height) {
+        return 0;
+    }
+
+    int x, z;
+    const Chunk* chunk = get_chunk(px, pz, x, z);
+    if (chunk == nullptr) {
+        return 0;
+    }
+    return (channel == Channel::SKY ? chunk->skylight : chunk->blocklight).get(x, y, z);
+}
+
+void LightEditor::set_level(Channel channel, int px, int y, int pz, uint8_t level) {
+    const int i = px / Chunk::Width;
+    const int j = pz / Chunk::Width;
+    if (!writable[i][j]) {
+        chunks[i][j] = world.get_writable_chunk(position + ChunkPosition{ i - 1, 0, j - 1 });
+        writable[i][j] = true;
+    }
+
+    int x, z;
+    Chunk* chunk = get_chunk(px, pz, x, z);
+    (channel == Channel::SKY ? chunk->skylight : chunk->blocklight).set(x, y, z, level);
+
+    // Faces sample the light of the voxel in front of them, so the
+    // neighbours' sections change too.
+    auto mark = [this](int nx, int ny, int nz) {
+        if (nx < 0 || nx >= 3 * Chunk::Width || nz < 0 || nz >= 3 * Chunk::Width || ny < 0 || ny >= Chunk::Height) return;
+        changed[nx / Chunk::Width][nz / Chunk::Width] |= static_cast<uint16_t>(1u << (ny / Chunk::SectionHeight));
+    };
+    mark(px, y, pz);
+    mark(px - 1, y, pz);
+    mark(px + 1, y, pz);
+    mark(px, y - 1, pz);
+    mark(px, y + 1, pz);
+    mark(px, y, pz - 1);
+    mark(px, y, pz + 1);
+}
+
+void LightEditor::remove(Channel channel) {
+    for (size_t head = 0; head < removals.size(); ++head) {
+        const Node node = removals[head];
+
+        auto clear = [&](int nx, int ny, int nz, bool below) {
+            const uint8_t level = get_level(channel, nx, ny, nz);
+            if (level == 0) return;
+
+            // Sky light goes straight down undimmed, so a full column below
+            // a removed one lost its source as well.
+            const bool lit_by_node = level < node.level
+                || (channel == Channel::SKY && below && node.level == Chunk::MaxLight && level == Chunk::MaxLight);
+            const int16_t x = static_cast<int16_t>(nx), y = static_cast<int16_t>(ny), z = static_cast<int16_t>(nz);
+            if (!lit_by_node) {
+                increases.push_back({ x, y, z, level });
+                return;
+            }
+
+            set_level(channel, nx, ny, nz, 0);
+            removals.push_back({ x, y, z, level });
+
+            // Emitters are their own source.
+            int local_x, local_z;
+            const uint8_t emission = (channel == Channel::BLOCK)
+                ? get_light_emission(get_chunk(nx, nz, local_x, local_z)->voxels[local_x][ny][local_z].type) : 0;
+            if (emission > 0) {
+                set_level(channel, nx, ny, nz, emission);
+                increases.push_back({ x, y, z, emission });
+            }
+        };
+
+        clear(node.x - 1, node.y, node.z, false);
+        clear(node.x + 1, node.y, node.z, false);
+        clear(node.x, node.y - 1, node.z, true);
+        clear(node.x, node.y + 1, node.z, false);
+        clear(node.x, node.y, node.z - 1, false);
+        clear(node.x, node.y, node.z + 1, false);
+    }
+}
+
+void LightEditor::spread(Channel channel) {
+    for (size_t head = 0; head < increases.size(); ++head) {
+        const Node node = increases[head];
+
+        // Queued with a level that was lowered since, or raised again with
+        // a newer entry further down the queue.
+        const uint8_t level = get_level(channel, node.x, node.y, node.z);
+        if (level != node.level || level <= 1) continue;
+
+        auto light = [&](int nx, int ny, int nz, bool below) {
+            const uint8_t next = (channel == Channel::SKY && below && level == Chunk::MaxLight) ? level : level - 1;
+            if (!is_air(nx, ny, nz) || get_level(channel, nx, ny, nz) >= next) return;
+
+            set_level(channel, nx, ny, nz, next);
+            increases.push_back({ static_cast<int16_t>(nx), static_cast<int16_t>(ny), static_cast<int16_t>(nz), next });
+        };
+
+        light(node.x - 1, node.y, node.z, false);
+        light(node.x + 1, node.y, node.z, false);
+        light(node.x, node.y - 1, node.z, true);
+        light(node.x, node.y + 1, node.z, false);
+        light(node.x, node.y, node.z - 1, false);
+        light(node.x, node.y, node.z + 1, false);
+    }
+}
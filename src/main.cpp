@@ -12,79 +12,30 @@
 #include <iostream>
 #include <sstream>
 #include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+#include <algorithm>
+#include <future>
 
 #include <voxel.hpp>
 #include <rendering.hpp>
 #include <chunk_mesh.hpp>
+#include <chunk_streamer.hpp>
 #include <input_handler.hpp>
-
-#include <siv/PerlinNoise.hpp>
-
-#define clamp(x, m) (x > m ? m : x)
+#include <memory_stats.hpp>
+#include <noise_bench.hpp>
 
 #define MCONCAT_IMPL(x, y) x##y
 #define MCONCAT(x, y) MCONCAT_IMPL(x, y)
 #define static_run(expr) static void* MCONCAT(nop, __LINE__) = ([&](){ {expr;} return nullptr; })(); (void)MCONCAT(nop, __LINE__);
 
-// VoxelType get_voxel(int x, int y, int z) {
-//     //constexpr float scale = 0.005f;
-//     constexpr size_t seed = 123456u;
-//     static_run(srand(seed));
-
-//     auto surface_y = 100 + rand() % 20;
-//     return (y < surface_y) ? VoxelType::STONE : VoxelType::NONE;
-// }
-
-int get_voxel_height(const Chunk& chunk, int x, int z) {
-    static constexpr unsigned int seed = 123456u;
-    static constexpr float inv_scale = 0.0007;
-    static constexpr int min_height = 100;
-    
-    static siv::PerlinNoise perlin{ seed };
-
-    const double noise = perlin.octave2D(
-        (x + chunk.position.x * Chunk::Width) * inv_scale,
-        (z + chunk.position.z * Chunk::Width) * inv_scale, 8, 0.5);
-
-    return clamp(min_height + abs(static_cast<int>(noise * Chunk::Height)), Chunk::Height);
-}
-
-void populate_chunk(Chunk& chunk) {
-    // 123456 is my favorite seed'
-
-    for (int x = 0; x < Chunk::Width; ++x) {
-        for (int z = 0; z < Chunk::Width; ++z) {
-            auto height = get_voxel_height(chunk, x, z);
-            
-            for (int y = 0; y < height; ++y) {
-                chunk.voxels[x][y][z].type = VoxelType::STONE;
-            }
-
-            if (height > 0 && height < 260) chunk.voxels[x][height-1][z].type = VoxelType::GRASS;
-            if (height > 1 && height < 272) chunk.voxels[x][height-2][z].type = VoxelType::DIRT;
-            if (height > 2 && height < 272) chunk.voxels[x][height-3][z].type = VoxelType::DIRT;
-
-            if (height == 0 || height == 1 || height == 2) { 
-                chunk.voxels[x][height][z].type = VoxelType::SAND;
-                for (int i = 0; i < height; ++i) {
-                    chunk.voxels[x][i][z].type = VoxelType::SAND;
-                }
-            }
-        }
+int main(int argc, char** argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--bench-noise") == 0) {
+        run_noise_benchmark(std::cout);
+        return 0;
     }
 
-
-
-    // for (int x = 0; x < Chunk::Width; ++x) {
-    //     for (int y = 0; y < Chunk::Height; ++y) {
-    //         for (int z = 0; z < Chunk::Width; ++z) {
-    //             chunk.voxels[x][y][z].type = get_voxel(x, y, z);
-    //         }
-    //     }
-    // }
-}
-
-int main() {
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW.\n";
         return 1;
@@ -126,85 +77,24 @@ int main() {
     glViewport(0, 0, 600, 600);
 
     // Chunk stuff 
-    std::cout << "Loading chunk...\n";
-
-    auto start = std::chrono::system_clock::now();
-
-    // auto chunk = new Chunk;
-    // chunk->fill(VoxelType::STONE);
-    // auto mesh = ChunkMesher(chunk, nullptr).generate_mesh();
-    // mesh.upload_buffers();
-
-    struct CoordChunkMesh {
-        ChunkMesh mesh;
-        ChunkPosition position;
-        size_t indices;
-    };
-    std::vector<CoordChunkMesh> meshes;
-
+    // Chunks are generated, meshed and uploaded around the camera by the
+    // streamer once the render loop starts.
     World world;
-    for (int x = 0; x < world.world_size.x; ++x) {
-        for (int y = 0; y < world.world_size.y; ++y) {
-            for (int z = 0; z < world.world_size.z; ++z) {
-                Chunk* chunk = new Chunk;
-                chunk->position = { x, y, z };
-                chunk->fill(VoxelType::NONE);
-                populate_chunk(*chunk);
-                
-                auto key = world.get_chunk_key(chunk->position);
-                world.loaded_chunks.insert({ key, chunk });
-            }
-        }
-        std::cout << "Generated " << (x * world.world_size.y * world.world_size.z) << " chunks.\n";
-    }
-
-    auto end = std::chrono::system_clock::now();
-    std::cout << "Elapsed: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
-
-    std::cout << "Generating meshes...\n";
-    start = std::chrono::system_clock::now();
     UVOffsetScheme uv_scheme = UVOffsetScheme::with_width(64, 16);
-
-    world.get_chunk_at({ 0, 0, 0 })->voxels[0][0][0].type = VoxelType::CRATE;
-
-    // stupid fucking dumb mesh counter for pretty printing
-    int counter = 0;
-    
-    for (int x = 0; x < world.world_size.x; ++x) {
-        for (int y = 0; y < world.world_size.y; ++y) {
-            for (int z = 0; z < world.world_size.z; ++z) {
-                Chunk* chunk = world.loaded_chunks.at(world.get_chunk_key(ChunkPosition{ x, y, z }));
-                if (!chunk) {
-                    std::cout << "Chunk at position " << x << ' ' << y << ' ' << z << " not found.\n";
-                    continue;
-                }
-                
-                auto mesh = ChunkMesher(chunk, &world, &uv_scheme).generate_mesh();
-                mesh.upload_buffers();
-                auto size = mesh.indices.size();
-                mesh.indices.clear();
-                mesh.vertices.clear();
-                meshes.push_back({ mesh, chunk->position, size });
-
-                ++counter;
-                if (counter % (world.world_size.y * world.world_size.z) == 0) {
-                    std::cout << "Generated " << counter << " meshes.\n";
-                }
-            }
-        }
+    RegionStorage storage{ "world" };
+    EditJournal journal{ storage.get_directory() };
+    if (auto replayed = journal.replay(storage); replayed > 0) {
+        std::cout << "Replayed " << replayed << " edits from the journal.\n";
     }
 
-    std::cout << "World remaining in memory.\n";
-    // std::cout << "Freeing all chunks...\n";
-    // for (auto& chunk_node : world.loaded_chunks) {
-    //     delete chunk_node.second;
-    // }
-    // world.loaded_chunks.clear();
+    ChunkIO chunk_io{ storage };
+    ChunkStreamer streamer{ world, uv_scheme, ChunkStreamer::Settings{}, &chunk_io, &journal };
+    std::cout << "Chunk I/O backend: " << chunk_io.get_backend_name() << "\n";
 
-    end = std::chrono::system_clock::now();
-    std::cout << "Elapsed: " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms\n";
-
-    std::cout << "Meshes generated.\n";
+    // Far chunks are tested against the near ones off the main thread, see
+    // the draw loop.
+    ThreadPool occlusion_worker{ 1 };
+    OcclusionCuller occlusion{ 128, 128 };
 
     // End of chunk stuff
 
@@ -234,6 +124,9 @@ int main() {
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
 
+    // 4 bytes per texel, and the mip chain adds another third.
+    MemoryCharge texture_memory{ MemoryCategory::TEXTURES, int64_t{ width } * height * 4 * 4 / 3 };
+
     stbi_image_free(data);
 
     WindowInputHandler input_handler;
@@ -247,6 +140,7 @@ int main() {
 
     GLuint u_lightpos = glGetUniformLocation(shader.program_id(), "u_lightpos");
     GLuint u_camerapos = glGetUniformLocation(shader.program_id(), "u_camerapos");
+    GLuint u_sky_brightness = glGetUniformLocation(shader.program_id(), "u_sky_brightness");
 
     // TEMP
 
@@ -273,8 +167,9 @@ int main() {
     glGenVertexArrays(1, &floor_vao);
     glGenBuffers(1, &floor_vbo);
 
-    float scale_x = world.world_size.x * Chunk::Width;
-    float scale_z = world.world_size.z * Chunk::Width;
+    // Water covers the streamed area and follows the camera in whole chunks.
+    float scale_x = (2 * streamer.settings.load_radius + 1) * Chunk::Width;
+    float scale_z = (2 * streamer.settings.load_radius + 1) * Chunk::Width;
 
     float water_verts[6*3*2*3] = {
         0, -0.25f+106, 0, 0.0f, 0.0f,       0.0f, 1.0f, 0.0f,
@@ -324,17 +219,21 @@ int main() {
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
     glGenerateMipmap(GL_TEXTURE_2D);
 
+    // Drivers pad RGB textures to 4 bytes per texel.
+    texture_memory.reset(texture_memory.get_bytes() + int64_t{ width } * height * 4 * 4 / 3);
+
     stbi_image_free(data);
     
     // END OF TEMP 
 
     while (!glfwWindowShouldClose(window)) {
-        start = std::chrono::system_clock::now();
+        auto start = std::chrono::system_clock::now();
         glClearColor(0.09, 0.098, 0.114, 1.0);
         //glClearColor(0.62, 0.81, 0.93, 1.0);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         input_handler.handle_framewise_key_input();
+        streamer.update(input_handler.camera_pos, input_handler.camera_front);
 
         glBindTexture(GL_TEXTURE_2D, texture);
 
@@ -353,10 +252,39 @@ int main() {
             shader.u_model_loc = glGetUniformLocation(shader.program_id(), "u_model");
             u_lightpos = glGetUniformLocation(shader.m_program_id, "u_lightpos");
             u_camerapos = glGetUniformLocation(shader.m_program_id, "u_camerapos");
+            u_sky_brightness = glGetUniformLocation(shader.m_program_id, "u_sky_brightness");
         } else if (glfwGetKey(window, GLFW_KEY_R) == GLFW_RELEASE && key_r_is_pressed) {
             key_r_is_pressed = false;
         }
 
+        // Debug edit, drops a crate a few blocks in front of the camera.
+        static bool key_b_is_pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !key_b_is_pressed) {
+            key_b_is_pressed = true;
+
+            auto target = input_handler.camera_pos + 4.0f * input_handler.camera_front;
+            streamer.set_voxel(Position{
+                static_cast<int>(std::floor(target.x)),
+                static_cast<int>(std::floor(target.y)) + 1,
+                static_cast<int>(std::floor(target.z)) }, VoxelType::CRATE);
+        } else if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE && key_b_is_pressed) {
+            key_b_is_pressed = false;
+        }
+
+        // Same with a glowing block, to try out block light.
+        static bool key_g_is_pressed = false;
+        if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !key_g_is_pressed) {
+            key_g_is_pressed = true;
+
+            auto target = input_handler.camera_pos + 4.0f * input_handler.camera_front;
+            streamer.set_voxel(Position{
+                static_cast<int>(std::floor(target.x)),
+                static_cast<int>(std::floor(target.y)) + 1,
+                static_cast<int>(std::floor(target.z)) }, VoxelType::ORE_WEIRD);
+        } else if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE && key_g_is_pressed) {
+            key_g_is_pressed = false;
+        }
+
         glm::mat4 view = input_handler.get_projection_mat() * input_handler.get_view_mat();
         shader.use();
         shader.set_u_model(glm::identity<glm::mat4>());
@@ -366,30 +294,162 @@ int main() {
         glUniform3fv(u_lightpos, 1, glm::value_ptr(light_pos));
         glUniform3fv(u_camerapos, 1, glm::value_ptr(input_handler.camera_pos));
 
-        for (auto&& meshinfo : meshes) {
-            glBindVertexArray(meshinfo.mesh.vao);
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshinfo.mesh.ebo);
+        // A day every 10 minutes, starting at sunrise. Meshes keep sky light
+        // apart from block light, so this is all a day costs.
+        constexpr double day_length = 600.0;
+        const double sun = std::sin(2.0 * std::numbers::pi * glfwGetTime() / day_length);
+        glUniform1f(u_sky_brightness, static_cast<float>(std::clamp(0.5 + 0.8 * sun, 0.15, 1.0)));
+
+        // Only sections in front of the camera that it can see into.
+        static std::vector<VisibleChunk> visible_chunks;
+        visible_chunks.clear();
+        streamer.get_visible_sections(Frustum::from_matrix(view), input_handler.camera_pos, visible_chunks);
+
+        // Chunks in the columns around the camera are drawn as they are. The
+        // rest are tested against occluders from the nearby chunks on the
+        // occlusion worker while the near ones are drawn.
+        static std::vector<OcclusionBox> occluders;
+        static std::vector<OcclusionBox> candidates;
+        static std::vector<size_t> far_chunks;
+        static std::vector<uint8_t> far_visible;
+        occluders.clear();
+        candidates.clear();
+        far_chunks.clear();
+        streamer.get_occluders(input_handler.camera_pos, 3, occluders);
+
+        const auto camera_chunk = ChunkPosition::from_world_pos(Position{
+            static_cast<int>(std::floor(input_handler.camera_pos.x)), 0,
+            static_cast<int>(std::floor(input_handler.camera_pos.z)) });
+        for (size_t i = 0; i < visible_chunks.size(); ++i) {
+            const auto* mesh = visible_chunks[i].mesh;
+            if (std::abs(mesh->position.x - camera_chunk.x) <= 1 && std::abs(mesh->position.z - camera_chunk.z) <= 1) continue;
+
+            far_chunks.push_back(i);
+            candidates.push_back({ mesh->get_origin() + mesh->bounds_min, mesh->get_origin() + mesh->bounds_max });
+        }
+        far_visible.assign(candidates.size(), 1);
+
+        std::promise<void> occlusion_done;
+        auto occlusion_result = occlusion_done.get_future();
+        occlusion_worker.submit([&, view_projection = view, camera_pos = input_handler.camera_pos] {
+            occlusion.begin(view_projection, camera_pos);
+            for (const auto& box : occluders) {
+                occlusion.add_occluder(box);
+            }
+            occlusion.finish_occluders();
 
-            auto pos = meshinfo.position;
-            shader.set_u_model(glm::translate(glm::identity<glm::mat4>(), 
-            { Chunk::Width * pos.x + 1, Chunk::Height * pos.y, Chunk::Width * pos.z + 1 }));
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                far_visible[i] = occlusion.is_visible(candidates[i]);
+            }
+            occlusion_done.set_value();
+        });
+
+        static std::vector<GLsizei> section_counts;
+        static std::vector<const void*> section_starts;
+        size_t drawn_meshes = 0;
+        size_t drawn_sections = 0;
+        size_t occluded_meshes = 0;
+
+        auto draw_chunk = [&](const VisibleChunk& visible) {
+            const auto& mesh = visible.mesh->mesh;
+
+            // One range per run of visible sections.
+            section_counts.clear();
+            section_starts.clear();
+            for (int section = 0; section < Chunk::SectionCount; ++section) {
+                if (!((visible.sections >> section) & 1)) continue;
+
+                int end = section + 1;
+                while (end < Chunk::SectionCount && ((visible.sections >> end) & 1)) ++end;
+
+                const auto count = static_cast<GLsizei>(mesh.section_offsets[end] - mesh.section_offsets[section]);
+                if (count > 0) {
+                    section_counts.push_back(count);
+                    section_starts.push_back(reinterpret_cast<const void*>(mesh.section_offsets[section] * sizeof (GLuint)));
+                }
+                drawn_sections += end - section;
+                section = end;
+            }
+            if (section_counts.empty()) return;
+            ++drawn_meshes;
+
+            glBindVertexArray(mesh.vao);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+
+            shader.set_u_model(glm::translate(glm::identity<glm::mat4>(), visible.mesh->get_origin()));
 
-            glDrawElements(GL_TRIANGLES, meshinfo.indices, GL_UNSIGNED_INT, nullptr);
+            glMultiDrawElements(GL_TRIANGLES, section_counts.data(), GL_UNSIGNED_INT,
+                section_starts.data(), static_cast<GLsizei>(section_counts.size()));
+        };
+
+        // `far_chunks` is in order, so this walks both at once.
+        for (size_t i = 0, far = 0; i < visible_chunks.size(); ++i) {
+            if (far < far_chunks.size() && far_chunks[far] == i) {
+                ++far;
+                continue;
+            }
+            draw_chunk(visible_chunks[i]);
+        }
+
+        occlusion_result.wait();
+        for (size_t far = 0; far < far_chunks.size(); ++far) {
+            if (!far_visible[far]) {
+                ++occluded_meshes;
+                continue;
+            }
+            draw_chunk(visible_chunks[far_chunks[far]]);
         }
 
         glCullFace(GL_BACK);
         glBindVertexArray(water_vao);
         glBindTexture(GL_TEXTURE_2D, water_texture);
 
-        shader.set_u_model(glm::identity<glm::mat4>());
+        // The water quad has no light attribute, it's always in full sky light
+        // (packed, see `Vertex`).
+        glVertexAttrib1f(3, Chunk::MaxLight * 16.0f);
+
+        auto water_origin = ChunkPosition::from_world_pos(Position{
+            static_cast<int>(std::floor(input_handler.camera_pos.x)), 0,
+            static_cast<int>(std::floor(input_handler.camera_pos.z)) });
+        shader.set_u_model(glm::translate(glm::identity<glm::mat4>(), {
+            Chunk::Width * (water_origin.x - streamer.settings.load_radius), 0,
+            Chunk::Width * (water_origin.z - streamer.settings.load_radius) }));
         glDrawArrays(GL_TRIANGLES, 0, 6);
         glCullFace(GL_FRONT);
 
-        end = std::chrono::system_clock::now();
+        auto end = std::chrono::system_clock::now();
         double elapsed 
             = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()) / 1000.0f;
         double fps = 1.0f / elapsed;
 
+        static auto last_stats_log = std::chrono::system_clock::now();
+        if (end - last_stats_log > std::chrono::seconds(5)) {
+            last_stats_log = end;
+
+            const auto& stats = streamer.prefetcher.stats;
+            std::cout << "Prefetch: " << stats.hits << " hits, " << stats.misses << " misses, " 
+                << stats.prefetched << " prefetched, " << stats.wasted << " wasted\n";
+            std::cout << "Culling: " << drawn_meshes << " of " << streamer.get_meshes().size()
+                << " chunk meshes drawn, " << drawn_sections << " sections visible, "
+                << occluded_meshes << " occluded\n";
+            std::cout << "Column cache: " << streamer.column_cache.stats.hits << " hits, "
+                << streamer.column_cache.stats.misses << " misses, "
+                << streamer.column_cache.stats.evictions << " evictions\n";
+            std::cout << "Decorations: " << streamer.decorations.get_pending_count() << " voxels queued\n";
+
+            size_t stages[static_cast<int>(ChunkStage::UPLOAD) + 1];
+            streamer.pipeline.count_stages(stages);
+            std::cout << "Chunk stages:";
+            for (int stage = 1; stage <= static_cast<int>(ChunkStage::UPLOAD); ++stage) {
+                std::cout << " " << stages[stage] << " " << get_stage_name(static_cast<ChunkStage>(stage));
+            }
+            std::cout << "\n";
+            chunk_io.print_stats(std::cout);
+            MemoryStats::print(std::cout);
+            std::cout << "Edit journal: " << journal.stats.records << " edits, " << journal.stats.commits
+                << " commits, " << journal.stats.checkpoints << " checkpoints\n";
+        }
+
         std::stringstream ss;
         ss << input_handler.camera_pos.x << " " << input_handler.camera_pos.y << " " << input_handler.camera_pos.z 
             << " | " << static_cast<int>(fps) << " fps";
@@ -399,6 +459,9 @@ int main() {
         glfwPollEvents();
     }
 
+    // Buffers must be released while the GL context still exists.
+    streamer.unload_all();
+
     glfwTerminate();
     // delete world; // not deleting yet because i need to do a whole bunch of unload and saving stuff first 
 }
@@ -0,0 +1,78 @@
+#include <memory_stats.hpp>
+
+#include <ostream>
+#include <iomanip>
+#include <atomic>
+
+namespace {
+    std::atomic<int64_t> counters[MemoryStats::CategoryCount] = {};
+
+    constexpr const char* category_names[MemoryStats::CategoryCount] = {
+        "voxels",
+        "mesh CPU",
+        "mesh GPU",
+        "textures",
+        "I/O buffers",
+        "overhead"
+    };
+}
+
+void MemoryStats::add(MemoryCategory category, int64_t bytes) {
+    counters[static_cast<int>(category)].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+int64_t MemoryStats::get(MemoryCategory category) {
+    return counters[static_cast<int>(category)].load(std::memory_order_relaxed);
+}
+
+int64_t MemoryStats::get_total() {
+    int64_t total = 0;
+    for (const auto& counter : counters) {
+        total += counter.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+const char* MemoryStats::get_category_name(MemoryCategory category) {
+    return category_names[static_cast<int>(category)];
+}
+
+void MemoryStats::print(std::ostream& out) {
+    constexpr double mib = 1024.0 * 1024.0;
+
+    const auto flags = out.flags();
+    const auto precision = out.precision();
+    out << std::fixed << std::setprecision(1) << "Memory:";
+
+    for (int i = 0; i < CategoryCount; ++i) {
+        auto category = static_cast<MemoryCategory>(i);
+        out << " " << get_category_name(category) << " " << static_cast<double>(get(category)) / mib << " MiB,";
+    }
+    out << " total " << static_cast<double>(get_total()) / mib << " MiB\n";
+
+    out.flags(flags);
+    out.precision(precision);
+}
+
+MemoryCharge::MemoryCharge(MemoryCategory category, int64_t bytes)
+    : category{category}, bytes{bytes} {
+    MemoryStats::add(category, bytes);
+}
+
+MemoryCharge::~MemoryCharge() {
+    MemoryStats::add(category, -bytes);
+}
+
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+    if (this != &other) {
+        MemoryStats::add(category, -bytes);
+        category = other.category;
+        bytes = std::exchange(other.bytes, 0);
+    }
+    return *this;
+}
+
+void MemoryCharge::reset(int64_t new_bytes) {
+    MemoryStats::add(category, new_bytes - bytes);
+    bytes = new_bytes;
+}
@@ -0,0 +1,255 @@
+#include <noise_bench.hpp>
+#include <noise_graph.hpp>
+#include <perlin_batch.hpp>
+
+#include <ostream>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+    constexpr int GridChunks = 16;
+    constexpr int GridSize = GridChunks * 16;
+    constexpr int Samples = GridSize * GridSize;
+
+    struct Sources {
+        PerlinBatch base{ siv::PerlinNoise{ 1u } };
+        PerlinBatch warp_x{ siv::PerlinNoise{ 2u } };
+        PerlinBatch warp_z{ siv::PerlinNoise{ 3u } };
+        PerlinBatch detail{ siv::PerlinNoise{ 4u } };
+    };
+
+    // Uses every node type: continents from warped base noise remapped by a
+    // spline, plus small-scale detail, clamped to the world height.
+    auto make_graph(const Sources& sources) {
+        auto continents = Noise::warp(
+            Noise::Octaves{ &sources.base, 0.0007f, 8 },
+            Noise::Octaves{ &sources.warp_x, 0.002f, 2 },
+            Noise::Octaves{ &sources.warp_z, 0.002f, 2 }, 40.0f);
+
+        return Noise::clamp(Noise::sum(
+            Noise::spline(continents, { -1.0f, -0.2f, 0.0f, 0.3f, 1.0f }, { 40.0f, 90.0f, 100.0f, 150.0f, 240.0f }),
+            Noise::scale(Noise::Octaves{ &sources.detail, 0.02f, 3 }, 6.0f)), 0.0f, 255.0f);
+    }
+
+    // The same graph as a tree of virtual nodes evaluated one whole buffer
+    // at a time, which is what an interpreted graph amounts to.
+    struct Node {
+        virtual ~Node() = default;
+        virtual void eval(const float* x, const float* z, float* out, int count) const = 0;
+    };
+
+    struct OctavesNode : Node {
+        Noise::Octaves octaves;
+
+        explicit OctavesNode(Noise::Octaves octaves) : octaves{octaves} {}
+
+        void eval(const float* x, const float* z, float* out, int count) const override {
+            for (int i = 0; i < count; ++i) {
+                out[i] = octaves.eval<NoiseLanes::ScalarOps>(x[i], z[i]);
+            }
+        }
+    };
+
+    struct WarpNode : Node {
+        std::unique_ptr<Node> source, warp_x, warp_z;
+        float strength;
+
+        WarpNode(std::unique_ptr<Node> source, std::unique_ptr<Node> warp_x, std::unique_ptr<Node> warp_z, float strength)
+            : source{std::move(source)}, warp_x{std::move(warp_x)}, warp_z{std::move(warp_z)}, strength{strength} {}
+
+        void eval(const float* x, const float* z, float* out, int count) const override {
+            std::vector<float> dx(count), dz(count);
+            warp_x->eval(x, z, dx.data(), count);
+            warp_z->eval(x, z, dz.data(), count);
+            for (int i = 0; i < count; ++i) {
+                dx[i] = x[i] + dx[i] * strength;
+                dz[i] = z[i] + dz[i] * strength;
+            }
+            source->eval(dx.data(), dz.data(), out, count);
+        }
+    };
+
+    struct SplineNode : Node {
+        std::unique_ptr<Node> a;
+        std::vector<float> inputs, outputs;
+
+        SplineNode(std::unique_ptr<Node> a, std::vector<float> inputs, std::vector<float> outputs)
+            : a{std::move(a)}, inputs{std::move(inputs)}, outputs{std::move(outputs)} {}
+
+        void eval(const float* x, const float* z, float* out, int count) const override {
+            a->eval(x, z, out, count);
+            for (int i = 0; i < count; ++i) {
+                float result = outputs[0];
+                for (size_t k = 0; k + 1 < inputs.size(); ++k) {
+                    const float t = (out[i] - inputs[k]) * (1.0f / (inputs[k + 1] - inputs[k]));
+                    const float along = NoiseLanes::ScalarOps::min(NoiseLanes::ScalarOps::max(t, 0.0f), 1.0f);
+                    result = result + along * (outputs[k + 1] - outputs[k]);
+                }
+                out[i] = result;
+            }
+        }
+    };
+
+    struct ScaleNode : Node {
+        std::unique_ptr<Node> a;
+        float factor;
+
+        ScaleNode(std::unique_ptr<Node> a, float factor) : a{std::move(a)}, factor{factor} {}
+
+        void eval(const float* x, const float* z, float* out, int count) const override {
+            a->eval(x, z, out, count);
+            for (int i = 0; i < count; ++i) {
+                out[i] = out[i] * factor + 0.0f;
+            }
+        }
+    };
+
+    struct SumNode : Node {
+        std::unique_ptr<Node> a, b;
+
+        SumNode(std::unique_ptr<Node> a, std::unique_ptr<Node> b) : a{std::move(a)}, b{std::move(b)} {}
+
+        void eval(const float* x, const float* z, float* out, int count) const override {
+            std::vector<float> other(count);
+            a->eval(x, z, out, count);
+            b->eval(x, z, other.data(), count);
+            for (int i = 0; i < count; ++i) {
+                out[i] = out[i] + other[i];
+            }
+        }
+    };
+
+    struct ClampNode : Node {
+        std::unique_ptr<Node> a;
+        float min, max;
+
+        ClampNode(std::unique_ptr<Node> a, float min, float max) : a{std::move(a)}, min{min}, max{max} {}
+
+        void eval(const float* x, const float* z, float* out, int count) const override {
+            a->eval(x, z, out, count);
+            for (int i = 0; i < count; ++i) {
+                out[i] = NoiseLanes::ScalarOps::min(NoiseLanes::ScalarOps::max(out[i], min), max);
+            }
+        }
+    };
+
+    auto make_node_graph(const Sources& sources) -> std::unique_ptr<Node> {
+        auto continents = std::make_unique<WarpNode>(
+            std::make_unique<OctavesNode>(Noise::Octaves{ &sources.base, 0.0007f, 8 }),
+            std::make_unique<OctavesNode>(Noise::Octaves{ &sources.warp_x, 0.002f, 2 }),
+            std::make_unique<OctavesNode>(Noise::Octaves{ &sources.warp_z, 0.002f, 2 }), 40.0f);
+
+        return std::make_unique<ClampNode>(std::make_unique<SumNode>(
+            std::make_unique<SplineNode>(std::move(continents),
+                std::vector{ -1.0f, -0.2f, 0.0f, 0.3f, 1.0f }, std::vector{ 40.0f, 90.0f, 100.0f, 150.0f, 240.0f }),
+            std::make_unique<ScaleNode>(std::make_unique<OctavesNode>(Noise::Octaves{ &sources.detail, 0.02f, 3 }), 6.0f)),
+            0.0f, 255.0f);
+    }
+
+    // Best of a few runs, in milliseconds.
+    template <typename Run>
+    auto time(Run&& run) -> double {
+        double best = 1e30;
+        for (int i = 0; i < 5; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            run();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        return best;
+    }
+
+    // Octave noise of one backend over a 2D and a 3D grid, in the shapes
+    // worldgen uses: 8 octaves for heights, 3 for density.
+    constexpr int GridSize3D = 64;
+    constexpr int Samples3D = GridSize3D * GridSize3D * GridSize3D;
+
+    struct BackendTimes {
+        double ms_2d;
+        double ms_3d;
+    };
+
+    auto time_backend(const NoiseSource& source, std::vector<float>& out_2d, std::vector<float>& out_3d) -> BackendTimes {
+        return {
+            time([&] { source.octave2D(out_2d, 0, 0, GridSize, GridSize, 0.0007f, 8); }),
+            time([&] { source.octave3D(out_3d, 0, 0, 0, GridSize3D, GridSize3D, GridSize3D, 0.015f, 3); })
+        };
+    }
+
+    // The same grids with `siv::PerlinNoise` in double, one sample at a time.
+    auto time_reference(const siv::PerlinNoise& perlin, std::vector<float>& out_2d, std::vector<float>& out_3d) -> BackendTimes {
+        return {
+            time([&] {
+                for (int x = 0; x < GridSize; ++x) {
+                    for (int z = 0; z < GridSize; ++z) {
+                        out_2d[x * GridSize + z] = static_cast<float>(perlin.octave2D(x * 0.0007, z * 0.0007, 8));
+                    }
+                }
+            }),
+            time([&] {
+                for (int x = 0; x < GridSize3D; ++x) {
+                    for (int y = 0; y < GridSize3D; ++y) {
+                        for (int z = 0; z < GridSize3D; ++z) {
+                            out_3d[(x * GridSize3D + y) * GridSize3D + z] =
+                                static_cast<float>(perlin.octave3D(x * 0.015, y * 0.015, z * 0.015, 3));
+                        }
+                    }
+                }
+            })
+        };
+    }
+
+    void print_backend(std::ostream& out, const char* name, BackendTimes times) {
+        out << "  " << name << ": 2D " << times.ms_2d << " ms (" << times.ms_2d * 1e6 / Samples << " ns/sample), "
+            << "3D " << times.ms_3d << " ms (" << times.ms_3d * 1e6 / Samples3D << " ns/sample)\n";
+    }
+}
+
+void run_noise_benchmark(std::ostream& out) {
+    const Sources sources;
+    const auto graph = make_graph(sources);
+    const auto nodes = make_node_graph(sources);
+
+    std::vector<float> fused(Samples), scalar(Samples), naive(Samples);
+    std::vector<float> xs(Samples), zs(Samples);
+    for (int x = 0; x < GridSize; ++x) {
+        for (int z = 0; z < GridSize; ++z) {
+            xs[x * GridSize + z] = static_cast<float>(x);
+            zs[x * GridSize + z] = static_cast<float>(z);
+        }
+    }
+
+    const double fused_ms = time([&] {
+        Noise::evaluate(graph, fused, 0, 0, GridSize, GridSize);
+    });
+
+    const double scalar_ms = time([&] {
+        for (int i = 0; i < Samples; ++i) {
+            scalar[i] = graph.eval<NoiseLanes::ScalarOps>(xs[i], zs[i]);
+        }
+    });
+
+    const double naive_ms = time([&] {
+        nodes->eval(xs.data(), zs.data(), naive.data(), Samples);
+    });
+
+    const bool identical = std::memcmp(fused.data(), scalar.data(), Samples * sizeof (float)) == 0
+        && std::memcmp(fused.data(), naive.data(), Samples * sizeof (float)) == 0;
+
+    out << "Noise graph over " << GridChunks * GridChunks << " chunk columns (" << Samples << " samples):\n"
+        << "  fused, " << NoiseLanes::SimdOps::Lanes << " lanes: " << fused_ms << " ms\n"
+        << "  fused, 1 lane:  " << scalar_ms << " ms\n"
+        << "  virtual nodes:  " << naive_ms << " ms\n"
+        << "  results " << (identical ? "identical" : "DIFFER") << "\n";
+
+    std::vector<float> out_2d(Samples), out_3d(Samples3D);
+    const siv::PerlinNoise reference{ 1u };
+
+    out << "Octave noise, " << Samples << " 2D samples x 8 octaves, " << Samples3D << " 3D samples x 3 octaves:\n";
+    print_backend(out, "siv::PerlinNoise (double)", time_reference(reference, out_2d, out_3d));
+    for (auto backend : { NoiseBackend::PERLIN, NoiseBackend::SIMPLEX }) {
+        const auto source = make_noise_source(backend, 1u);
+        print_backend(out, get_noise_backend_name(backend), time_backend(*source, out_2d, out_3d));
+    }
+}
@@ -0,0 +1,27 @@
+#include <noise_source.hpp>
+#include <perlin_batch.hpp>
+#include <simplex_batch.hpp>
+
+auto get_noise_backend_name(NoiseBackend backend) -> const char* {
+    switch (backend) {
+        case NoiseBackend::PERLIN: return "perlin";
+        case NoiseBackend::SIMPLEX: return "simplex";
+    }
+    return "unknown";
+}
+
+NoiseSource::NoiseSource(NoiseBackend backend, const siv::PerlinNoise& perlin) : backend{backend} {
+    const auto& state = perlin.serialize();
+    for (int i = 0; i < 512; ++i) {
+        permutation[i] = state[i & 255];
+    }
+}
+
+auto make_noise_source(NoiseBackend backend, unsigned int seed) -> std::unique_ptr<NoiseSource> {
+    const siv::PerlinNoise perlin{ seed };
+
+    if (backend == NoiseBackend::SIMPLEX) {
+        return std::make_unique<SimplexBatch>(perlin);
+    }
+    return std::make_unique<PerlinBatch>(perlin);
+}
@@ -0,0 +1,241 @@
+#include <occlusion_culler.hpp>
+#include <noise_lanes.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    using Ops = NoiseLanes::SimdOps;
+
+    // Pixel centres of a batch, relative to its first pixel.
+    struct LaneOffsets {
+        float values[8] = { 0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f };
+    };
+    constexpr LaneOffsets lane_offsets;
+
+    // Corners of a box by index: bit 0 picks max x, bit 1 max y, bit 2 max z.
+    auto get_corner(const OcclusionBox& box, int i) -> glm::vec3 {
+        return {
+            (i & 1) ? box.max.x : box.min.x,
+            (i & 2) ? box.max.y : box.min.y,
+            (i & 4) ? box.max.z : box.min.z
+        };
+    }
+
+    // Corners of each face, in order around it, like `Chunk::Face`.
+    constexpr int face_corners[6][4] = {
+        { 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+        { 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+        { 0, 1, 3, 2 }, { 4, 5, 7, 6 }
+    };
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height)
+    : width{ width }, height{ height } {
+    for (int w = width, h = height; w > 0 && h > 0; w /= 2, h /= 2) {
+        levels.emplace_back(static_cast<size_t>(w) * h, 1.0f);
+    }
+}
+
+void OcclusionCuller::begin(const glm::mat4& view_projection, const glm::vec3& camera_pos) {
+    this->view_projection = view_projection;
+    this->camera_pos = camera_pos;
+    std::fill(levels[0].begin(), levels[0].end(), 1.0f);
+}
+
+void OcclusionCuller::add_occluder(const OcclusionBox& box) {
+    ScreenPoint corners[8];
+    for (int i = 0; i < 8; ++i) {
+        if (!project(get_corner(box, i), corners[i])) return;
+    }
+
+    // Back faces: the ones facing away from the camera.
+    const bool back[6] = {
+        camera_pos.x > box.min.x, camera_pos.x < box.max.x,
+        camera_pos.y > box.min.y, camera_pos.y < box.max.y,
+        camera_pos.z > box.min.z, camera_pos.z < box.max.z
+    };
+
+    for (int face = 0; face < 6; ++face) {
+        if (!back[face]) continue;
+
+        const auto& indices = face_corners[face];
+        const ScreenPoint quad[4] = {
+            corners[indices[0]], corners[indices[1]], corners[indices[2]], corners[indices[3]]
+        };
+        rasterize_quad(quad);
+    }
+}
+
+void OcclusionCuller::finish_occluders() {
+    int w = width;
+    int h = height;
+    for (size_t level = 1; level < levels.size(); ++level) {
+        const auto& below = levels[level - 1];
+        auto& current = levels[level];
+        const int below_width = w;
+        w /= 2;
+        h /= 2;
+
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                const size_t i = static_cast<size_t>(2 * y) * below_width + 2 * x;
+                current[static_cast<size_t>(y) * w + x] = std::max(
+                    std::max(below[i], below[i + 1]),
+                    std::max(below[i + below_width], below[i + below_width + 1]));
+            }
+        }
+    }
+}
+
+auto OcclusionCuller::is_visible(const OcclusionBox& box) const -> bool {
+    float min_x = static_cast<float>(width), max_x = 0.0f;
+    float min_y = static_cast<float>(height), max_y = 0.0f;
+    float nearest = 1.0f;
+    for (int i = 0; i < 8; ++i) {
+        ScreenPoint point;
+        if (!project(get_corner(box, i), point)) return true;
+
+        min_x = std::min(min_x, point.x);
+        max_x = std::max(max_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_y = std::max(max_y, point.y);
+        nearest = std::min(nearest, point.z);
+    }
+
+    // Every pixel the rectangle touches, the rest of it is off screen.
+    const int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    const int x1 = std::min(width - 1, static_cast<int>(std::ceil(max_x)) - 1);
+    const int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    const int y1 = std::min(height - 1, static_cast<int>(std::ceil(max_y)) - 1);
+    if (x0 > x1 || y0 > y1) {
+        return true;
+    }
+
+    // Coarse first: the level where the rectangle spans a few texels.
+    int level = 0;
+    while (level + 1 < static_cast<int>(levels.size()) && ((x1 >> level) - (x0 >> level) > 2 || (y1 >> level) - (y0 >> level) > 2)) {
+        ++level;
+    }
+    const int level_width = width >> level;
+    bool hidden = true;
+    for (int y = y0 >> level; y <= (y1 >> level) && hidden; ++y) {
+        for (int x = x0 >> level; x <= (x1 >> level); ++x) {
+            if (levels[level][static_cast<size_t>(y) * level_width + x] >= nearest) {
+                hidden = false;
+                break;
+            }
+        }
+    }
+    if (hidden || level == 0) {
+        return !hidden;
+    }
+
+    // Then every pixel, a batch at a time. Lanes outside the rectangle are
+    // masked off.
+    const auto depth = Ops::set(nearest);
+    for (int y = y0; y <= y1; ++y) {
+        const float* row = &levels[0][static_cast<size_t>(y) * width];
+        for (int x = x0 / Ops::Lanes * Ops::Lanes; x <= x1; x += Ops::Lanes) {
+            const int in_front = Ops::to_bits(Ops::less(Ops::load(row + x), depth));
+            int lanes = (1 << Ops::Lanes) - 1;
+            if (x < x0) lanes &= ~((1 << (x0 - x)) - 1);
+            if (x + Ops::Lanes - 1 > x1) lanes &= (1 << (x1 - x + 1)) - 1;
+
+            if (~in_front & lanes) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+auto OcclusionCuller::project(const glm::vec3& point, ScreenPoint& out) const -> bool {
+    const glm::vec4 clip = view_projection * glm::vec4{ point, 1.0f };
+    if (clip.z < -clip.w || clip.w <= 0.0f) {
+        return false;
+    }
+
+    out.x = (clip.x / clip.w * 0.5f + 0.5f) * static_cast<float>(width);
+    out.y = (clip.y / clip.w * 0.5f + 0.5f) * static_cast<float>(height);
+    out.z = clip.z / clip.w;
+    return true;
+}
+
+void OcclusionCuller::rasterize_quad(const ScreenPoint (&points)[4]) {
+    // Twice the signed area, the sign tells the winding.
+    float area = 0.0f;
+    for (int i = 0; i < 4; ++i) {
+        const auto& p = points[i];
+        const auto& q = points[(i + 1) % 4];
+        area += p.x * q.y - q.x * p.y;
+    }
+
+    // Edge on: covers nothing.
+    if (std::abs(area) < 1e-6f) {
+        return;
+    }
+
+    // Edge functions a*x + b*y + c, not negative inside.
+    float edge_a[4], edge_b[4], edge_c[4];
+    for (int i = 0; i < 4; ++i) {
+        const auto& p = points[i];
+        const auto& q = points[(i + 1) % 4];
+        const float sign = (area > 0.0f) ? 1.0f : -1.0f;
+        edge_a[i] = sign * (p.y - q.y);
+        edge_b[i] = sign * (q.x - p.x);
+        edge_c[i] = -(edge_a[i] * p.x + edge_b[i] * p.y);
+    }
+
+    // Depth plane z = dz_dx*x + dz_dy*y + z0, through the first three
+    // points. The quad is planar, so the fourth is on it as well.
+    const auto& a = points[0];
+    const auto& b = points[1];
+    const auto& c = points[2];
+    const float determinant = (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+    if (std::abs(determinant) < 1e-6f) {
+        return;
+    }
+    const float dz_dx = ((b.z - a.z) * (c.y - a.y) - (c.z - a.z) * (b.y - a.y)) / determinant;
+    const float dz_dy = ((c.z - a.z) * (b.x - a.x) - (b.z - a.z) * (c.x - a.x)) / determinant;
+    const float z0 = a.z - dz_dx * a.x - dz_dy * a.y;
+
+    float min_x = points[0].x, max_x = points[0].x;
+    float min_y = points[0].y, max_y = points[0].y;
+    for (const auto& point : points) {
+        min_x = std::min(min_x, point.x);
+        max_x = std::max(max_x, point.x);
+        min_y = std::min(min_y, point.y);
+        max_y = std::max(max_y, point.y);
+    }
+
+    const int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
+    const int x1 = std::min(width - 1, static_cast<int>(std::ceil(max_x)));
+    const int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
+    const int y1 = std::min(height - 1, static_cast<int>(std::ceil(max_y)));
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    const auto offsets = Ops::load(lane_offsets.values);
+    const auto zero = Ops::set(0.0f);
+
+    for (int y = y0; y <= y1; ++y) {
+        const float center_y = static_cast<float>(y) + 0.5f;
+        float* row = &levels[0][static_cast<size_t>(y) * width];
+
+        for (int x = x0 / Ops::Lanes * Ops::Lanes; x <= x1; x += Ops::Lanes) {
+            const auto center_x = Ops::add(Ops::set(static_cast<float>(x)), offsets);
+
+            auto outside = Ops::set_int(0);
+            for (int i = 0; i < 4; ++i) {
+                const auto edge = Ops::add(Ops::mul(Ops::set(edge_a[i]), center_x), Ops::set(edge_b[i] * center_y + edge_c[i]));
+                outside = Ops::or_int(outside, Ops::less(edge, zero));
+            }
+
+            const auto depth = Ops::add(Ops::mul(Ops::set(dz_dx), center_x), Ops::set(dz_dy * center_y + z0));
+            const auto current = Ops::load(row + x);
+            Ops::store(row + x, Ops::select(outside, current, Ops::min(depth, current)));
+        }
+    }
+}
@@ -0,0 +1,555 @@
+#include <region_file.hpp>
+#include <world_gen.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Payload format tags, first byte of every payload.
+    constexpr uint8_t payload_rle = 0;
+    constexpr uint8_t payload_delta = 1;
+
+    constexpr size_t voxel_count = Chunk::Width * Chunk::Height * Chunk::Width;
+
+    // Floor division, so negative chunk coordinates land in the right region.
+    auto floor_div(int a, int b) -> int {
+        return (a >= 0) ? a / b : -((-a + b - 1) / b);
+    }
+
+    void put_varint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    auto get_varint(std::span<const uint8_t> in, size_t& pos, uint32_t& value) -> bool {
+        value = 0;
+        for (int shift = 0; shift < 32; shift += 7) {
+            if (pos >= in.size()) return false;
+
+            uint8_t byte = in[pos++];
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) return true;
+        }
+        return false;
+    }
+}
+
+RegionPosition RegionPosition::from_chunk_pos(ChunkPosition pos) {
+    return {
+        floor_div(pos.x, RegionFile::Size),
+        pos.y,
+        floor_div(pos.z, RegionFile::Size)
+    };
+}
+
+RegionFile::RegionFile(const std::filesystem::path& path) {
+    if (!open_file(path)) {
+        std::cerr << "Failed to open region file " << path.string() << ".\n";
+        return;
+    }
+
+    if (file_size < HeaderSize) {
+        // New (or truncated beyond repair) file, start from an empty header.
+        const uint32_t preamble[2] = { Magic, Version };
+        write_at(0, preamble, sizeof preamble);
+        write_at(sizeof preamble, entries, sizeof entries);
+        file_size = HeaderSize;
+        return;
+    }
+
+    uint32_t preamble[2] = {};
+    if (ensure_mapped(file_size)) {
+        std::memcpy(preamble, mapping, sizeof preamble);
+    }
+
+    if (preamble[0] != Magic || preamble[1] != Version) {
+        // Never write into a file we don't understand, it might be from a
+        // newer build. Chunks in this region get regenerated instead.
+        std::cerr << "Region file " << path.string() << " has an unknown format, not using it.\n";
+        unmap();
+        close_file();
+        return;
+    }
+
+    std::memcpy(entries, mapping + sizeof preamble, sizeof entries);
+}
+
+RegionFile::~RegionFile() {
+    unmap();
+    close_file();
+}
+
+bool RegionFile::is_open() const {
+#ifdef _WIN32
+    return file_handle != nullptr;
+#else
+    return fd >= 0;
+#endif
+}
+
+int RegionFile::get_entry_index(ChunkPosition pos) {
+    auto region = RegionPosition::from_chunk_pos(pos);
+    int local_x = pos.x - region.x * Size;
+    int local_z = pos.z - region.z * Size;
+    return local_x * Size + local_z;
+}
+
+bool RegionFile::has_chunk(ChunkPosition pos) const {
+    return entries[get_entry_index(pos)].length != 0;
+}
+
+std::span<const uint8_t> RegionFile::get_payload(ChunkPosition pos) {
+    const auto& entry = entries[get_entry_index(pos)];
+    if (entry.length == 0) {
+        return {};
+    }
+
+    const uint64_t end = static_cast<uint64_t>(entry.offset) + entry.length;
+    if (end > file_size || !ensure_mapped(end)) {
+        return {};
+    }
+
+    return { mapping + entry.offset, entry.length };
+}
+
+bool RegionFile::read_chunk(Chunk& chunk) {
+    auto payload = get_payload(chunk.position);
+    if (payload.empty()) {
+        return false;
+    }
+
+    return decode_chunk(payload, chunk);
+}
+
+RegionFile::Entry RegionFile::get_entry(ChunkPosition pos) const {
+    return entries[get_entry_index(pos)];
+}
+
+void RegionFile::set_entry(ChunkPosition pos, Entry entry) {
+    entries[get_entry_index(pos)] = entry;
+}
+
+uint64_t RegionFile::get_entry_file_offset(ChunkPosition pos) {
+    return 2 * sizeof (uint32_t) + get_entry_index(pos) * sizeof (Entry);
+}
+
+uint64_t RegionFile::reserve(uint32_t length) {
+    if (file_size + length > UINT32_MAX) {
+        return 0;
+    }
+
+    uint64_t offset = file_size;
+    file_size += length;
+    return offset;
+}
+
+bool RegionFile::write_payload(ChunkPosition pos, const std::vector<uint8_t>& payload) {
+    if (!is_open() || payload.empty()) {
+        return false;
+    }
+
+    uint64_t offset = reserve(static_cast<uint32_t>(payload.size()));
+    if (offset == 0) {
+        return false;
+    }
+
+    // Payload first, header second: a crash in between leaves the old entry
+    // pointing at the old (still intact) payload.
+    if (!write_at(offset, payload.data(), payload.size())) {
+        return false;
+    }
+
+    Entry entry = { static_cast<uint32_t>(offset), static_cast<uint32_t>(payload.size()) };
+    if (!write_at(get_entry_file_offset(pos), &entry, sizeof entry)) {
+        return false;
+    }
+    set_entry(pos, entry);
+
+    return true;
+}
+
+bool RegionFile::write_chunk(const Chunk& chunk) {
+    return write_payload(chunk.position, encode_chunk(chunk));
+}
+
+std::vector<uint8_t> RegionFile::encode_chunk(const Chunk& chunk) {
+    // Voxels are stored x-major with z innermost, so runs follow z rows and
+    // wrap into the next y level. Terrain below the surface and sky above it
+    // collapse into a handful of runs per x slice.
+    const auto* voxels = reinterpret_cast<const uint8_t*>(chunk.voxels);
+
+    std::vector<uint8_t> out;
+    out.reserve(1024);
+    out.push_back(payload_rle);
+    put_varint(out, chunk.spill_sources);
+
+    size_t i = 0;
+    while (i < voxel_count) {
+        const uint8_t type = voxels[i];
+        size_t run = 1;
+        while (i + run < voxel_count && voxels[i + run] == type) {
+            ++run;
+        }
+
+        put_varint(out, static_cast<uint32_t>(run));
+        out.push_back(type);
+        i += run;
+    }
+
+    return out;
+}
+
+bool RegionFile::decode_chunk(std::span<const uint8_t> payload, Chunk& chunk) {
+    static_assert(sizeof (Voxel) == 1, "RLE payloads assume one byte per voxel.");
+
+    if (payload.empty() || payload[0] != payload_rle) {
+        return false;
+    }
+
+    size_t pos = 1;
+    uint32_t spill_sources;
+    if (!get_varint(payload, pos, spill_sources) || spill_sources > AllSpillSources) {
+        return false;
+    }
+
+    auto* voxels = reinterpret_cast<uint8_t*>(chunk.voxels);
+
+    size_t i = 0;
+    while (i < voxel_count) {
+        uint32_t run;
+        if (!get_varint(payload, pos, run) || pos >= payload.size() || run > voxel_count - i) {
+            return false;
+        }
+
+        std::memset(voxels + i, payload[pos++], run);
+        i += run;
+    }
+
+    if (pos != payload.size()) {
+        return false;
+    }
+
+    chunk.update_heightmap();
+    chunk.update_occupancy();
+    chunk.edited_voxels.clear();
+    chunk.spill_sources = static_cast<uint16_t>(spill_sources);
+    chunk.is_snapshot = true;
+    chunk.dirty = false;
+    return true;
+}
+
+std::vector<uint8_t> RegionFile::encode_chunk_delta(const Chunk& chunk) {
+    const auto* voxels = reinterpret_cast<const uint8_t*>(chunk.voxels);
+
+    // Sorted, so indices can be stored as small gaps.
+    std::vector<uint16_t> indices{ chunk.edited_voxels.begin(), chunk.edited_voxels.end() };
+    std::sort(indices.begin(), indices.end());
+
+    std::vector<uint8_t> out;
+    out.reserve(8 + indices.size() * 3);
+    out.push_back(payload_delta);
+    put_varint(out, static_cast<uint32_t>(indices.size()));
+
+    uint32_t previous = 0;
+    for (auto index : indices) {
+        put_varint(out, index - previous);
+        out.push_back(voxels[index]);
+        previous = index;
+    }
+
+    return out;
+}
+
+bool RegionFile::is_delta_payload(std::span<const uint8_t> payload) {
+    return !payload.empty() && payload[0] == payload_delta;
+}
+
+bool RegionFile::apply_chunk_delta(std::span<const uint8_t> payload, Chunk& chunk) {
+    if (!is_delta_payload(payload)) {
+        return false;
+    }
+
+    auto* voxels = reinterpret_cast<uint8_t*>(chunk.voxels);
+
+    size_t pos = 1;
+    uint32_t count;
+    if (!get_varint(payload, pos, count) || count > voxel_count) {
+        return false;
+    }
+
+    chunk.edited_voxels.clear();
+    chunk.edited_voxels.reserve(count);
+
+    uint32_t index = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t gap;
+        if (!get_varint(payload, pos, gap) || pos >= payload.size() || index + gap >= voxel_count) {
+            return false;
+        }
+
+        index += gap;
+        voxels[index] = payload[pos++];
+        chunk.edited_voxels.insert(static_cast<uint16_t>(index));
+    }
+
+    chunk.update_heightmap();
+    chunk.update_occupancy();
+
+    chunk.is_snapshot = false;
+    chunk.dirty = false;
+    return pos == payload.size();
+}
+
+#ifdef _WIN32
+
+bool RegionFile::open_file(const std::filesystem::path& path) {
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    file_handle = handle;
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(handle, &size);
+    file_size = static_cast<uint64_t>(size.QuadPart);
+    return true;
+}
+
+void RegionFile::close_file() {
+    if (file_handle) CloseHandle(file_handle);
+    file_handle = nullptr;
+}
+
+bool RegionFile::ensure_mapped(size_t size) {
+    if (mapping && mapped_size >= size) {
+        return true;
+    }
+
+    unmap();
+
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle) {
+        return false;
+    }
+
+    mapping = static_cast<const uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (!mapping) {
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+        return false;
+    }
+
+    mapped_size = file_size;
+    return mapped_size >= size;
+}
+
+void RegionFile::unmap() {
+    if (mapping) UnmapViewOfFile(mapping);
+    if (mapping_handle) CloseHandle(mapping_handle);
+
+    mapping = nullptr;
+    mapping_handle = nullptr;
+    mapped_size = 0;
+}
+
+bool RegionFile::read_at(uint64_t offset, void* data, size_t size) const {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD read = 0;
+    return ReadFile(file_handle, data, static_cast<DWORD>(size), &read, &overlapped)
+        && read == size;
+}
+
+bool RegionFile::sync() {
+    return FlushFileBuffers(file_handle) != 0;
+}
+
+bool RegionFile::write_at(uint64_t offset, const void* data, size_t size) {
+    OVERLAPPED overlapped = {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+    DWORD written = 0;
+    return WriteFile(file_handle, data, static_cast<DWORD>(size), &written, &overlapped)
+        && written == size;
+}
+
+#else
+
+bool RegionFile::open_file(const std::filesystem::path& path) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    fstat(fd, &st);
+    file_size = static_cast<uint64_t>(st.st_size);
+    return true;
+}
+
+void RegionFile::close_file() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+}
+
+bool RegionFile::ensure_mapped(size_t size) {
+    if (mapping && mapped_size >= size) {
+        return true;
+    }
+
+    unmap();
+
+    void* ptr = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        return false;
+    }
+
+    mapping = static_cast<const uint8_t*>(ptr);
+    mapped_size = file_size;
+    return mapped_size >= size;
+}
+
+void RegionFile::unmap() {
+    if (mapping) {
+        munmap(const_cast<uint8_t*>(mapping), mapped_size);
+    }
+
+    mapping = nullptr;
+    mapped_size = 0;
+}
+
+bool RegionFile::read_at(uint64_t offset, void* data, size_t size) const {
+    auto* bytes = static_cast<uint8_t*>(data);
+    while (size > 0) {
+        ssize_t read = pread(fd, bytes, size, static_cast<off_t>(offset));
+        if (read <= 0) {
+            return false;
+        }
+
+        bytes += read;
+        offset += read;
+        size -= read;
+    }
+    return true;
+}
+
+bool RegionFile::write_at(uint64_t offset, const void* data, size_t size) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written <= 0) {
+            return false;
+        }
+
+        bytes += written;
+        offset += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool RegionFile::sync() {
+    return fsync(fd) == 0;
+}
+
+#endif
+
+RegionStorage::RegionStorage(std::filesystem::path directory)
+    : RegionStorage(std::move(directory), Settings{}) {}
+
+RegionStorage::RegionStorage(std::filesystem::path directory, Settings settings)
+    : settings{settings}, directory{std::move(directory)} {
+    std::error_code ec;
+    std::filesystem::create_directories(this->directory, ec);
+    if (ec) {
+        std::cerr << "Failed to create world directory " << this->directory.string() << ": " << ec.message() << "\n";
+    }
+}
+
+RegionFile* RegionStorage::get_region(ChunkPosition pos) {
+    auto region = RegionPosition::from_chunk_pos(pos);
+    auto key = std::to_string(region.x) + "_" + std::to_string(region.y) + "_" + std::to_string(region.z);
+
+    auto it = regions.find(key);
+    if (it != regions.end()) {
+        return it->second.get();
+    }
+
+    auto file = std::make_unique<RegionFile>(directory / ("r." + key + ".bin"));
+    if (!file->is_open()) {
+        return nullptr;
+    }
+
+    return regions.insert({ key, std::move(file) }).first->second.get();
+}
+
+std::vector<RegionFile*> RegionStorage::get_regions() const {
+    std::vector<RegionFile*> files;
+    files.reserve(regions.size());
+    for (const auto& [key, file] : regions) {
+        files.push_back(file.get());
+    }
+    return files;
+}
+
+std::vector<uint8_t> RegionStorage::encode_for_save(Chunk& chunk) const {
+    if (settings.save_mode == SaveMode::DELTA && !chunk.is_snapshot
+        && chunk.edited_voxels.size() <= settings.compact_threshold) {
+        return RegionFile::encode_chunk_delta(chunk);
+    }
+
+    compact(chunk);
+    return RegionFile::encode_chunk(chunk);
+}
+
+bool RegionStorage::decode_payload(std::span<const uint8_t> payload, Chunk& chunk) {
+    if (!RegionFile::is_delta_payload(payload)) {
+        return RegionFile::decode_chunk(payload, chunk);
+    }
+
+    chunk.fill(VoxelType::NONE);
+    populate_chunk(chunk);
+    return RegionFile::apply_chunk_delta(payload, chunk);
+}
+
+void RegionStorage::compact(Chunk& chunk) {
+    chunk.edited_voxels.clear();
+    chunk.is_snapshot = true;
+}
+
+bool RegionStorage::load_chunk(Chunk& chunk) {
+    auto* region = get_region(chunk.position);
+    if (!region) {
+        return false;
+    }
+
+    auto payload = region->get_payload(chunk.position);
+    return !payload.empty() && decode_payload(payload, chunk);
+}
+
+bool RegionStorage::save_chunk(Chunk& chunk) {
+    auto* region = get_region(chunk.position);
+    if (!region || !region->write_payload(chunk.position, encode_for_save(chunk))) {
+        return false;
+    }
+
+    chunk.dirty = false;
+    return true;
+}
@@ -0,0 +1,32 @@
+#include <simplex_batch.hpp>
+#include <noise_lanes.hpp>
+
+using namespace NoiseLanes;
+
+SimplexBatch::SimplexBatch(const siv::PerlinNoise& perlin) : NoiseSource(NoiseBackend::SIMPLEX, perlin) {}
+
+void SimplexBatch::octave2D(std::span<float> out, int origin_x, int origin_z, int width, int depth,
+        float scale, int octave_count, float persistence) const {
+    for (int x = 0; x < width; ++x) {
+        const float sample_x = static_cast<float>(origin_x + x) * scale;
+
+        fill_row(out.data() + x * depth, depth, origin_z, scale, [&]<typename Ops>(Ops, typename Ops::F z) {
+            return simplex_octaves2D<Ops>(permutation, Ops::set(sample_x), z, octave_count, persistence);
+        });
+    }
+}
+
+void SimplexBatch::octave3D(std::span<float> out, int origin_x, int origin_y, int origin_z,
+        int width, int height, int depth, float scale, int octave_count, float persistence) const {
+    for (int x = 0; x < width; ++x) {
+        const float sample_x = static_cast<float>(origin_x + x) * scale;
+
+        for (int y = 0; y < height; ++y) {
+            const float sample_y = static_cast<float>(origin_y + y) * scale;
+
+            fill_row(out.data() + (x * height + y) * depth, depth, origin_z, scale, [&]<typename Ops>(Ops, typename Ops::F z) {
+                return simplex_octaves3D<Ops>(permutation, Ops::set(sample_x), Ops::set(sample_y), z, octave_count, persistence);
+            });
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#include <thread_pool.hpp>
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+
+    workers.reserve(thread_count);
+    for (unsigned int i = 0; i < thread_count; ++i) {
+        workers.emplace_back([this](std::stop_token stop) { worker_loop(stop); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    for (auto& worker : workers) {
+        worker.request_stop();
+    }
+    condition.notify_all();
+    workers.clear();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    {
+        std::lock_guard lock{ mutex };
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+}
+
+void ThreadPool::worker_loop(std::stop_token stop) {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock{ mutex };
+            condition.wait(lock, stop, [this] { return !tasks.empty(); });
+
+            // Remaining tasks are dropped on shutdown.
+            if (stop.stop_requested()) {
+                return;
+            }
+
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+
+        task();
+    }
+}
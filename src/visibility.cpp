@@ -0,0 +1,133 @@
+#include <visibility.hpp>
+
+#include <algorithm>
+#include <bitset>
+
+namespace {
+    constexpr int Width = Chunk::Width;
+    constexpr int Height = Chunk::SectionHeight;
+
+    // Section voxels as one index, z fastest.
+    constexpr auto get_index(int x, int y, int z) -> int {
+        return (x * Height + y) * Width + z;
+    }
+
+    auto get_faces(int x, int y, int z) -> uint8_t {
+        using Face = Chunk::Face;
+        auto bit = [](Face face) { return static_cast<uint8_t>(1 << static_cast<int>(face)); };
+
+        uint8_t faces = 0;
+        if (x == 0) faces |= bit(Face::X_NEG);
+        if (x == Width - 1) faces |= bit(Face::X_POS);
+        if (y == 0) faces |= bit(Face::Y_NEG);
+        if (y == Height - 1) faces |= bit(Face::Y_POS);
+        if (z == 0) faces |= bit(Face::Z_NEG);
+        if (z == Width - 1) faces |= bit(Face::Z_POS);
+        return faces;
+    }
+}
+
+auto SectionConnectivity::compute(const Chunk& chunk, int section) -> SectionConnectivity {
+    // Every face sees every other one through an empty section, none
+    // through a full one.
+    if (chunk.is_section_empty(section)) {
+        return { (uint64_t{ 1 } << (Chunk::FaceCount * Chunk::FaceCount)) - 1 };
+    }
+    if (chunk.is_section_full(section)) {
+        return {};
+    }
+
+    const int y_begin = section * Height;
+    std::bitset<Width * Height * Width> visited;
+    uint16_t stack[Width * Height * Width];
+
+    SectionConnectivity connectivity;
+    auto fill = [&](int x, int y, int z) {
+        const int start = get_index(x, y, z);
+        if (visited[start] || chunk.voxels[x][y_begin + y][z].type != VoxelType::NONE) return;
+
+        visited[start] = true;
+        int size = 0;
+        stack[size++] = static_cast<uint16_t>(start);
+
+        uint8_t faces = 0;
+        while (size > 0) {
+            const int index = stack[--size];
+            const int vz = index % Width;
+            const int vy = index / Width % Height;
+            const int vx = index / Width / Height;
+            faces |= get_faces(vx, vy, vz);
+
+            auto visit = [&](int nx, int ny, int nz) {
+                if (nx < 0 || nx >= Width || ny < 0 || ny >= Height || nz < 0 || nz >= Width) return;
+
+                const int next = get_index(nx, ny, nz);
+                if (visited[next] || chunk.voxels[nx][y_begin + ny][nz].type != VoxelType::NONE) return;
+
+                visited[next] = true;
+                stack[size++] = static_cast<uint16_t>(next);
+            };
+
+            visit(vx - 1, vy, vz);
+            visit(vx + 1, vy, vz);
+            visit(vx, vy - 1, vz);
+            visit(vx, vy + 1, vz);
+            visit(vx, vy, vz - 1);
+            visit(vx, vy, vz + 1);
+        }
+
+        for (int a = 0; a < Chunk::FaceCount; ++a) {
+            if (!((faces >> a) & 1)) continue;
+            for (int b = 0; b < Chunk::FaceCount; ++b) {
+                if ((faces >> b) & 1) connectivity.bits |= uint64_t{ 1 } << (a * Chunk::FaceCount + b);
+            }
+        }
+    };
+
+    // Pockets that don't reach a face can't connect anything, so only
+    // flood from the faces.
+    for (int x = 0; x < Width; ++x) {
+        for (int y = 0; y < Height; ++y) {
+            // Rows inside the section only touch faces at their ends.
+            const bool on_face = x == 0 || x == Width - 1 || y == 0 || y == Height - 1;
+            for (int z = 0; z < Width; z += on_face ? 1 : Width - 1) {
+                fill(x, y, z);
+            }
+        }
+    }
+
+    return connectivity;
+}
+
+auto ChunkOccluders::compute(const Chunk& chunk) -> ChunkOccluders {
+    ChunkOccluders occluders;
+    for (int gx = 0; gx < GroupCount; ++gx) {
+        for (int gz = 0; gz < GroupCount; ++gz) {
+            int top = Chunk::Height;
+            for (int x = gx * GroupWidth; x < (gx + 1) * GroupWidth; ++x) {
+                for (int z = gz * GroupWidth; z < (gz + 1) * GroupWidth; ++z) {
+                    top = std::min<int>(top, chunk.heightmap[x][z]);
+                }
+            }
+
+            // Down to the first air in any of the columns.
+            int bottom = top;
+            bool solid = true;
+            while (solid && bottom > 0 && top - bottom < MaxDepth) {
+                for (int x = gx * GroupWidth; x < (gx + 1) * GroupWidth && solid; ++x) {
+                    for (int z = gz * GroupWidth; z < (gz + 1) * GroupWidth; ++z) {
+                        if (chunk.voxels[x][bottom - 1][z].type == VoxelType::NONE) {
+                            solid = false;
+                            break;
+                        }
+                    }
+                }
+                if (solid) --bottom;
+            }
+
+            occluders.bottom[gx][gz] = static_cast<int16_t>(bottom);
+            occluders.top[gx][gz] = static_cast<int16_t>(top);
+        }
+    }
+    return occluders;
+}
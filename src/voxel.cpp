@@ -1,5 +1,6 @@
 #include <voxel.hpp>
 
+#include <algorithm>
 #include <cmath>
 
 UVOffsetScheme UVOffsetScheme::with_width(int image_width, int texture_width) {
@@ -63,9 +64,72 @@ UVOffsetScheme UVOffsetScheme::with_width(int image_width, int texture_width) {
         }
     });
 
+    scheme.uvs.insert({ VoxelType::ROCKS,
+        VoxelUV{
+            .front = (base + UV{ 3.0f, 2.0f }) / inv_scale,
+            .back = (base + UV{ 3.0f, 2.0f }) / inv_scale,
+            .right = (base + UV{ 3.0f, 2.0f }) / inv_scale,
+            .left = (base + UV{ 3.0f, 2.0f }) / inv_scale,
+            .top = (base + UV{ 3.0f, 2.0f }) / inv_scale,
+            .bottom = (base + UV{ 3.0f, 2.0f }) / inv_scale
+        }
+    });
+
+    scheme.uvs.insert({ VoxelType::ORE_IRON,
+        VoxelUV{
+            .front = (base + UV{ 0.0f, 1.0f }) / inv_scale,
+            .back = (base + UV{ 0.0f, 1.0f }) / inv_scale,
+            .right = (base + UV{ 0.0f, 1.0f }) / inv_scale,
+            .left = (base + UV{ 0.0f, 1.0f }) / inv_scale,
+            .top = (base + UV{ 0.0f, 1.0f }) / inv_scale,
+            .bottom = (base + UV{ 0.0f, 1.0f }) / inv_scale
+        }
+    });
+
+    scheme.uvs.insert({ VoxelType::ORE_GOLD,
+        VoxelUV{
+            .front = (base + UV{ 1.0f, 1.0f }) / inv_scale,
+            .back = (base + UV{ 1.0f, 1.0f }) / inv_scale,
+            .right = (base + UV{ 1.0f, 1.0f }) / inv_scale,
+            .left = (base + UV{ 1.0f, 1.0f }) / inv_scale,
+            .top = (base + UV{ 1.0f, 1.0f }) / inv_scale,
+            .bottom = (base + UV{ 1.0f, 1.0f }) / inv_scale
+        }
+    });
+
+    scheme.uvs.insert({ VoxelType::ORE_COAL,
+        VoxelUV{
+            .front = (base + UV{ 2.0f, 1.0f }) / inv_scale,
+            .back = (base + UV{ 2.0f, 1.0f }) / inv_scale,
+            .right = (base + UV{ 2.0f, 1.0f }) / inv_scale,
+            .left = (base + UV{ 2.0f, 1.0f }) / inv_scale,
+            .top = (base + UV{ 2.0f, 1.0f }) / inv_scale,
+            .bottom = (base + UV{ 2.0f, 1.0f }) / inv_scale
+        }
+    });
+
+    scheme.uvs.insert({ VoxelType::ORE_WEIRD,
+        VoxelUV{
+            .front = (base + UV{ 1.0f, 0.0f }) / inv_scale,
+            .back = (base + UV{ 1.0f, 0.0f }) / inv_scale,
+            .right = (base + UV{ 1.0f, 0.0f }) / inv_scale,
+            .left = (base + UV{ 1.0f, 0.0f }) / inv_scale,
+            .top = (base + UV{ 1.0f, 0.0f }) / inv_scale,
+            .bottom = (base + UV{ 1.0f, 0.0f }) / inv_scale
+        }
+    });
+
     return scheme;
 }
 
+uint8_t get_light_emission(VoxelType type) {
+    switch (type) {
+        // It glows, that's what's weird about it.
+        case VoxelType::ORE_WEIRD: return Chunk::MaxLight;
+        default: return 0;
+    }
+}
+
 ChunkPosition ChunkPosition::from_world_pos(int x, int y, int z) {
     return {
         static_cast<int>(x / Chunk::Width),
@@ -98,4 +162,116 @@ void Chunk::fill(VoxelType type) {
             }
         }
     }
-}
\ No newline at end of file
+
+    for (int x = 0; x < Width; ++x) {
+        for (int z = 0; z < Width; ++z) {
+            heightmap[x][z] = (type == VoxelType::NONE) ? 0 : Height;
+        }
+    }
+
+    const bool solid = type != VoxelType::NONE;
+    solid_count = solid ? Width * Height * Width : 0;
+    emitter_count = (get_light_emission(type) > 0) ? Width * Height * Width : 0;
+    for (int section = 0; section < SectionCount; ++section) {
+        section_solid_count[section] = solid ? SectionVolume : 0;
+        for (int face = 0; face < FaceCount; ++face) {
+            section_face_solid_count[section][face] = solid ? get_face_area(static_cast<Face>(face)) : 0;
+        }
+    }
+}
+
+void Chunk::set_voxel(int x, int y, int z, VoxelType type) {
+    set_generated_voxel(x, y, z, type);
+    dirty = true;
+
+    if (!is_snapshot) {
+        edited_voxels.insert(get_voxel_index(x, y, z));
+    }
+}
+
+void Chunk::set_generated_voxel(int x, int y, int z, VoxelType type) {
+    const bool was_solid = voxels[x][y][z].type != VoxelType::NONE;
+    const bool is_solid = type != VoxelType::NONE;
+
+    emitter_count -= (get_light_emission(voxels[x][y][z].type) > 0) ? 1 : 0;
+    emitter_count += (get_light_emission(type) > 0) ? 1 : 0;
+    voxels[x][y][z].type = type;
+
+    if (was_solid != is_solid) {
+        add_occupancy(x, y, z, is_solid ? 1 : -1);
+    }
+
+    auto& height = heightmap[x][z];
+    if (type != VoxelType::NONE && y >= height) {
+        height = static_cast<uint16_t>(y + 1);
+    } else if (type == VoxelType::NONE && y + 1 == height) {
+        // Removed the top voxel, walk down to the next solid one.
+        while (height > 0 && voxels[x][height - 1][z].type == VoxelType::NONE) {
+            --height;
+        }
+    }
+}
+
+void Chunk::update_heightmap() {
+    for (int x = 0; x < Width; ++x) {
+        for (int z = 0; z < Width; ++z) {
+            int y = Height;
+            while (y > 0 && voxels[x][y - 1][z].type == VoxelType::NONE) {
+                --y;
+            }
+            heightmap[x][z] = static_cast<uint16_t>(y);
+        }
+    }
+}
+
+int Chunk::get_slice_height(int x) const {
+    int height = 0;
+    for (int z = 0; z < Width; ++z) {
+        height = std::max(height, static_cast<int>(heightmap[x][z]));
+    }
+    return height;
+}
+
+void Chunk::update_occupancy() {
+    solid_count = 0;
+    emitter_count = 0;
+    for (int section = 0; section < SectionCount; ++section) {
+        section_solid_count[section] = 0;
+        for (int face = 0; face < FaceCount; ++face) {
+            section_face_solid_count[section][face] = 0;
+        }
+    }
+
+    for (int x = 0; x < Width; ++x) {
+        for (int y = 0; y < Height; ++y) {
+            for (int z = 0; z < Width; ++z) {
+                if (voxels[x][y][z].type != VoxelType::NONE) {
+                    add_occupancy(x, y, z, 1);
+                }
+                if (get_light_emission(voxels[x][y][z].type) > 0) {
+                    ++emitter_count;
+                }
+            }
+        }
+    }
+}
+
+bool Chunk::is_section_face_opaque(int section, Face face) const {
+    return section_face_solid_count[section][static_cast<int>(face)] == get_face_area(face);
+}
+
+void Chunk::add_occupancy(int x, int y, int z, int delta) {
+    const int section = y / SectionHeight;
+    const int local_y = y % SectionHeight;
+    auto& faces = section_face_solid_count[section];
+
+    solid_count += delta;
+    section_solid_count[section] += delta;
+
+    if (x == 0) faces[static_cast<int>(Face::X_NEG)] += delta;
+    if (x == Width - 1) faces[static_cast<int>(Face::X_POS)] += delta;
+    if (local_y == 0) faces[static_cast<int>(Face::Y_NEG)] += delta;
+    if (local_y == SectionHeight - 1) faces[static_cast<int>(Face::Y_POS)] += delta;
+    if (z == 0) faces[static_cast<int>(Face::Z_NEG)] += delta;
+    if (z == Width - 1) faces[static_cast<int>(Face::Z_POS)] += delta;
+}
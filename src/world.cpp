@@ -7,16 +7,41 @@ Chunk* World::get_chunk_at(ChunkPosition pos) {
         return nullptr;
     }
 
+    return chunk_it->second.get();
+}
+
+std::shared_ptr<const Chunk> World::pin_chunk(ChunkPosition pos) const {
+    auto chunk_it = loaded_chunks.find(get_chunk_key(pos));
+    if (chunk_it == loaded_chunks.end()) {
+        return nullptr;
+    }
+
     return chunk_it->second;
 }
 
+Chunk* World::get_writable_chunk(ChunkPosition pos) {
+    auto chunk_it = loaded_chunks.find(get_chunk_key(pos));
+    if (chunk_it == loaded_chunks.end()) {
+        return nullptr;
+    }
+
+    // Pins are only taken on this thread, so a count of 1 can't go up
+    // behind our back. A count that drops concurrently only costs a copy.
+    auto& chunk = chunk_it->second;
+    if (chunk.use_count() > 1) {
+        chunk = std::make_shared<Chunk>(*chunk);
+    }
+
+    return chunk.get();
+}
+
 // slow fucking algorithm btw
 Voxel World::get_voxel_at(Position world_pos) const {
     auto chunk_pos = ChunkPosition::from_world_pos(world_pos);
     
-    if (chunk_pos.x >= world_size.x || chunk_pos.x < -world_size.x
-        || chunk_pos.y >= world_size.y || chunk_pos.y < -world_size.y
-        || chunk_pos.z >= world_size.z || chunk_pos.z < -world_size.z) {
+    // Chunks are streamed in along x/z, so only the vertical extent of the
+    // world is fixed.
+    if (chunk_pos.y >= world_size.y || chunk_pos.y < 0) {
         return default_voxel;
     }
 
@@ -33,13 +58,27 @@ Voxel World::get_voxel_at(Position world_pos) const {
         return default_voxel;
     }
 
-    int local_x = world_pos.x % Chunk::Width;
-    int local_y = world_pos.y % Chunk::Height;
-    int local_z = world_pos.z % Chunk::Width;
+    int local_x = world_pos.x - chunk_pos.x * Chunk::Width;
+    int local_y = world_pos.y - chunk_pos.y * Chunk::Height;
+    int local_z = world_pos.z - chunk_pos.z * Chunk::Width;
 
     return chunk_it->second->voxels[local_x][local_y][local_z];
 }
 
+bool World::set_voxel_at(Position world_pos, VoxelType type) {
+    auto chunk_pos = ChunkPosition::from_world_pos(world_pos);
+    Chunk* chunk = get_writable_chunk(chunk_pos);
+    if (!chunk) {
+        return false;
+    }
+
+    chunk->set_voxel(
+        world_pos.x - chunk_pos.x * Chunk::Width,
+        world_pos.y - chunk_pos.y * Chunk::Height,
+        world_pos.z - chunk_pos.z * Chunk::Width, type);
+    return true;
+}
+
 std::string World::get_chunk_key(ChunkPosition pos) const {
     return std::to_string(pos.x) + "_" 
         + std::to_string(pos.y) + "_" 
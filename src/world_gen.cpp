@@ -0,0 +1,462 @@
+#include <world_gen.hpp>
+
+#include <algorithm>
+#include <cstdint>
+
+// VoxelType get_voxel(int x, int y, int z) {
+//     //constexpr float scale = 0.005f;
+//     constexpr size_t seed = 123456u;
+//     static_run(srand(seed));
+
+//     auto surface_y = 100 + rand() % 20;
+//     return (y < surface_y) ? VoxelType::STONE : VoxelType::NONE;
+// }
+
+namespace {
+    // Division rounding towards negative infinity.
+    constexpr auto floor_div(int a, int b) -> int {
+        return (a >= 0) ? a / b : (a - b + 1) / b;
+    }
+
+    // splitmix64, seeded from the chunk position, so a chunk's features
+    // don't depend on the order chunks are generated in.
+    struct FeatureRandom {
+        uint64_t state;
+
+        FeatureRandom(unsigned int seed, ChunkPosition pos, uint64_t salt)
+            : state{ seed ^ (static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32)
+                ^ static_cast<uint32_t>(pos.z) ^ (static_cast<uint64_t>(static_cast<uint32_t>(pos.y)) << 48)
+                ^ (salt * 0x9e3779b97f4a7c15ull) } {}
+
+        auto next() -> uint64_t {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        // In [min, max).
+        auto range(int min, int max) -> int {
+            return min + static_cast<int>(next() % static_cast<uint64_t>(max - min));
+        }
+
+        // In [0, 1).
+        auto unit() -> float {
+            return static_cast<float>(next() >> 40) / static_cast<float>(1 << 24);
+        }
+    };
+
+    // Places feature voxels relative to the chunk at `position`: straight
+    // into `chunk` when they land inside, into `spill` otherwise. Without a
+    // chunk only the spill is kept.
+    struct FeatureWriter {
+        Chunk* chunk;
+        ChunkPosition position;
+        std::vector<FeatureSpill>& spill;
+
+        void place(int x, int y, int z, VoxelType type, VoxelType replace) {
+            if (y < 0 || y >= Chunk::Height) {
+                return;
+            }
+
+            const int dx = floor_div(x, Chunk::Width);
+            const int dz = floor_div(z, Chunk::Width);
+            const auto local = FeatureVoxel{
+                static_cast<uint8_t>(x - dx * Chunk::Width), static_cast<uint8_t>(y),
+                static_cast<uint8_t>(z - dz * Chunk::Width), type, replace };
+
+            if (dx == 0 && dz == 0) {
+                if (chunk && chunk->voxels[local.x][local.y][local.z].type == replace) {
+                    chunk->set_generated_voxel(local.x, local.y, local.z, type);
+                }
+                return;
+            }
+
+            const auto target = position + ChunkPosition{ dx, 0, dz };
+            auto it = std::find_if(spill.begin(), spill.end(), [&](const FeatureSpill& s) {
+                return s.target == target;
+            });
+            if (it == spill.end()) {
+                it = spill.insert(spill.end(), FeatureSpill{ position, target, {} });
+            }
+            it->voxels.push_back(local);
+        }
+    };
+
+    struct Ore {
+        VoxelType type;
+        int veins;
+        int max_y;
+        int length;
+    };
+
+    // Veins are random walks through stone. The walks don't look at the
+    // terrain, only the voxels they land on do, so what they spill into
+    // neighbours only depends on the seed and the chunk position.
+    void place_ores(const WorldGenerator::Settings& settings, FeatureWriter& writer) {
+        const int base = writer.position.y * Chunk::Height;
+
+        const Ore ores[] = {
+            { VoxelType::ORE_COAL, settings.coal_veins, 160, 10 },
+            { VoxelType::ORE_IRON, settings.iron_veins, 80, 8 },
+            { VoxelType::ORE_GOLD, settings.gold_veins, 40, 6 },
+        };
+
+        for (int kind = 0; kind < 3; ++kind) {
+            const auto& ore = ores[kind];
+            FeatureRandom random{ settings.seed, writer.position, static_cast<uint64_t>(kind) };
+
+            for (int i = 0; i < ore.veins; ++i) {
+                int x = random.range(0, Chunk::Width);
+                int y = random.range(1, ore.max_y) - base;
+                int z = random.range(0, Chunk::Width);
+
+                for (int step = 0; step < ore.length; ++step) {
+                    writer.place(x, y, z, ore.type, VoxelType::STONE);
+
+                    const int axis = random.range(0, 3);
+                    const int dir = random.range(0, 2) * 2 - 1;
+                    (axis == 0 ? x : axis == 1 ? y : z) += dir;
+                }
+            }
+        }
+    }
+}
+
+WorldGenerator::WorldGenerator(Settings settings)
+    : settings{settings}, noise{ make_noise_source(settings.backend, settings.seed) },
+      density_noise{ make_noise_source(settings.backend, settings.seed + 1) },
+      cave_noise{ make_noise_source(settings.backend, settings.seed + 2) },
+      temperature_noise{ make_noise_source(settings.backend, settings.seed + 3) },
+      humidity_noise{ make_noise_source(settings.backend, settings.seed + 4) },
+      height_graph{ make_height_graph() },
+      climate{ *temperature_noise, *humidity_noise, settings.climate_scale, settings.climate_octaves } {}
+
+WorldGenerator::WorldGenerator() : WorldGenerator(Settings{}) {}
+
+auto WorldGenerator::make_height_graph() const -> HeightGraph {
+    const auto peak = static_cast<float>(Chunk::Height);
+
+    return Noise::spline(Noise::Octaves{ noise.get(), settings.inv_scale, settings.octaves },
+        { -1.0f, 0.0f, 1.0f }, { peak, 0.0f, peak });
+}
+
+auto WorldGenerator::get_surface_height(float relief, const ColumnBiome& biome) const -> int {
+    const float height = static_cast<float>(settings.min_height) + biome.height_offset + relief * biome.height_scale;
+
+    // Cut off at the top of the chunk.
+    return static_cast<int>(std::clamp(height, 0.0f, static_cast<float>(Chunk::Height)));
+}
+
+int WorldGenerator::get_height(const Chunk& chunk, int x, int z) const {
+    const int world_x = x + chunk.position.x * Chunk::Width;
+    const int world_z = z + chunk.position.z * Chunk::Width;
+
+    float relief;
+    Noise::evaluate(height_graph, { &relief, 1 }, world_x, world_z, 1, 1);
+
+    return get_surface_height(relief, climate.get_column(world_x, world_z));
+}
+
+void WorldGenerator::get_column_fields(ChunkPosition pos, ColumnFields& fields) const {
+    // Every column at once, same values `get_height` gives.
+    float relief[Chunk::Width * Chunk::Width];
+    Noise::evaluate(height_graph, relief, pos.x * Chunk::Width, pos.z * Chunk::Width, Chunk::Width, Chunk::Width);
+
+    ColumnBiome biomes[Chunk::Width][Chunk::Width];
+    climate.get_columns(pos, biomes);
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int z = 0; z < Chunk::Width; ++z) {
+            fields.heights[x][z] = static_cast<int16_t>(get_surface_height(relief[x * Chunk::Width + z], biomes[x][z]));
+            fields.biomes[x][z] = biomes[x][z].biome;
+        }
+    }
+}
+
+void WorldGenerator::populate(Chunk& chunk) const {
+    ColumnFields fields;
+    get_column_fields(chunk.position, fields);
+    populate(chunk, fields);
+}
+
+void WorldGenerator::populate(Chunk& chunk, const ColumnFields& fields) const {
+    populate_terrain(chunk, fields);
+    populate_surface(chunk, fields);
+}
+
+void WorldGenerator::populate_terrain(Chunk& chunk, const ColumnFields& fields) const {
+    if (settings.mode == TerrainMode::DENSITY) {
+        terrain_density(chunk, fields);
+    } else {
+        terrain_heightmap(chunk, fields);
+    }
+}
+
+void WorldGenerator::populate_surface(Chunk& chunk, const ColumnFields& fields) const {
+    if (settings.mode == TerrainMode::DENSITY) {
+        surface_density(chunk, fields);
+    } else {
+        surface_heightmap(chunk, fields);
+    }
+}
+
+void WorldGenerator::terrain_heightmap(Chunk& chunk, const ColumnFields& fields) const {
+    // Heights are in world space, stacked chunks get their slice of the column.
+    const int base = chunk.position.y * Chunk::Height;
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int z = 0; z < Chunk::Width; ++z) {
+            const int height = fields.heights[x][z];
+            for (int y = std::max(base, 0); y < std::min(height, base + Chunk::Height); ++y) {
+                chunk.voxels[x][y - base][z].type = VoxelType::STONE;
+            }
+        }
+    }
+}
+
+void WorldGenerator::surface_heightmap(Chunk& chunk, const ColumnFields& fields) const {
+    const int base = chunk.position.y * Chunk::Height;
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int z = 0; z < Chunk::Width; ++z) {
+            const int height = fields.heights[x][z];
+            const auto& biome = get_biome_info(fields.biomes[x][z]);
+
+            auto set = [&](int world_y, VoxelType type) {
+                const int y = world_y - base;
+                if (y >= 0 && y < Chunk::Height) chunk.voxels[x][y][z].type = type;
+            };
+
+            if (height > 0) set(height - 1, biome.surface);
+            for (int depth = 1; depth <= biome.filler_depth && height - 1 - depth >= 0; ++depth) {
+                set(height - 1 - depth, biome.filler);
+            }
+
+            if (height == 0 || height == 1 || height == 2) { 
+                for (int i = 0; i <= height; ++i) {
+                    set(i, VoxelType::SAND);
+                }
+            }
+
+            // The chunk starts out empty, so the surface is the column top.
+            const int top = (height <= 2) ? height + 1 : height;
+            chunk.heightmap[x][z] = static_cast<uint16_t>(std::min(std::max(top - base, 0), Chunk::Height));
+        }
+    }
+
+    chunk.update_occupancy();
+
+
+
+    // for (int x = 0; x < Chunk::Width; ++x) {
+    //     for (int y = 0; y < Chunk::Height; ++y) {
+    //         for (int z = 0; z < Chunk::Width; ++z) {
+    //             chunk.voxels[x][y][z].type = get_voxel(x, y, z);
+    //         }
+    //     }
+    // }
+}
+
+void WorldGenerator::terrain_density(Chunk& chunk, const ColumnFields& fields) const {
+    static constexpr int Step = DensityStep;
+    static constexpr int PointsXZ = Chunk::Width / Step + 1;
+    static constexpr int PointsY = Chunk::Height / Step + 1;
+    static constexpr int LatticeSize = PointsXZ * PointsY * PointsXZ;
+
+    static_assert(Chunk::Width % Step == 0 && Chunk::Height % Step == 0);
+
+    // Noise on the coarse lattice, indexed [x][y][z] like `octave3D` fills it.
+    // Lattice points on the far faces are shared with the neighbouring chunks,
+    // so the fields line up across chunk borders.
+    float density[LatticeSize];
+    float caves[LatticeSize];
+
+    const auto pos = chunk.position;
+    const int lattice_x = pos.x * (Chunk::Width / Step);
+    const int lattice_y = pos.y * (Chunk::Height / Step);
+    const int lattice_z = pos.z * (Chunk::Width / Step);
+
+    density_noise->octave3D(density, lattice_x, lattice_y, lattice_z, PointsXZ, PointsY, PointsXZ,
+        settings.density_scale * Step, settings.density_octaves);
+    cave_noise->octave3D(caves, lattice_x, lattice_y, lattice_z, PointsXZ, PointsY, PointsXZ,
+        settings.cave_scale * Step, settings.cave_octaves);
+
+    auto at = [](int x, int y, int z) {
+        return (x * PointsY + y) * PointsXZ + z;
+    };
+
+    // Interpolation weight and lattice cell of each voxel along a z row.
+    float ramp[Chunk::Width];
+    for (int z = 0; z < Chunk::Width; ++z) {
+        ramp[z] = static_cast<float>(z % Step) / Step;
+    }
+
+    const int base = pos.y * Chunk::Height;
+    const float squash = settings.squash;
+    const float cave_width = settings.cave_width;
+
+    for (int x = 0; x < Chunk::Width; ++x) {
+        const int cell_x = x / Step;
+        const float tx = static_cast<float>(x % Step) / Step;
+
+        float heights[Chunk::Width];
+        for (int z = 0; z < Chunk::Width; ++z) {
+            heights[z] = fields.heights[x][z];
+        }
+
+        for (int y = 0; y < Chunk::Height; ++y) {
+            const int cell_y = y / Step;
+            const float ty = static_cast<float>(y % Step) / Step;
+
+            // Interpolate along x and y at the lattice points of this z row...
+            float density_points[PointsXZ];
+            float cave_points[PointsXZ];
+            for (int k = 0; k < PointsXZ; ++k) {
+                auto bilerp = [&](const float* field) {
+                    const float bottom = field[at(cell_x, cell_y, k)]
+                        + (field[at(cell_x + 1, cell_y, k)] - field[at(cell_x, cell_y, k)]) * tx;
+                    const float top = field[at(cell_x, cell_y + 1, k)]
+                        + (field[at(cell_x + 1, cell_y + 1, k)] - field[at(cell_x, cell_y + 1, k)]) * tx;
+                    return bottom + (top - bottom) * ty;
+                };
+                density_points[k] = bilerp(density);
+                cave_points[k] = bilerp(caves);
+            }
+
+            // ...then along z for the whole row at once. The loops below are
+            // straight-line float math over 16 lanes, which the compiler
+            // turns into a handful of vector instructions.
+            float density_low[Chunk::Width], density_high[Chunk::Width];
+            float cave_low[Chunk::Width], cave_high[Chunk::Width];
+            for (int z = 0; z < Chunk::Width; ++z) {
+                density_low[z] = density_points[z / Step];
+                density_high[z] = density_points[z / Step + 1];
+                cave_low[z] = cave_points[z / Step];
+                cave_high[z] = cave_points[z / Step + 1];
+            }
+
+            const float world_y = static_cast<float>(base + y);
+            auto& row = chunk.voxels[x][y];
+
+            // The bottom layer is never carved, the world has no floor otherwise.
+            const bool carve = world_y >= 1.0f;
+
+            // No short-circuiting in here, branches keep the loop scalar.
+            for (int z = 0; z < Chunk::Width; ++z) {
+                const float noise_value = density_low[z] + (density_high[z] - density_low[z]) * ramp[z];
+                const float cave_value = cave_low[z] + (cave_high[z] - cave_low[z]) * ramp[z];
+
+                const bool solid = heights[z] - world_y + noise_value * squash > 0.0f;
+                const bool cave = carve & (cave_value < cave_width) & (cave_value > -cave_width);
+
+                row[z].type = (solid & !cave) ? VoxelType::STONE : VoxelType::NONE;
+            }
+        }
+    }
+
+}
+
+void WorldGenerator::surface_density(Chunk& chunk, const ColumnFields& fields) const {
+    // Top layers of every exposed surface, overhangs and cave ceilings'
+    // tops included.
+    for (int x = 0; x < Chunk::Width; ++x) {
+        for (int z = 0; z < Chunk::Width; ++z) {
+            const auto& biome = get_biome_info(fields.biomes[x][z]);
+
+            int depth = 0;
+            for (int y = Chunk::Height - 1; y >= 0; --y) {
+                auto& voxel = chunk.voxels[x][y][z];
+                if (voxel.type == VoxelType::NONE) {
+                    depth = 0;
+                    continue;
+                }
+
+                if (depth == 0) {
+                    voxel.type = biome.surface;
+                } else if (depth <= biome.filler_depth) {
+                    voxel.type = biome.filler;
+                }
+                ++depth;
+            }
+        }
+    }
+
+    chunk.update_heightmap();
+    chunk.update_occupancy();
+}
+
+void WorldGenerator::decorate(Chunk& chunk, const ColumnFields& fields, std::vector<FeatureSpill>& spill) const {
+    FeatureWriter writer{ &chunk, chunk.position, spill };
+    place_ores(settings, writer);
+
+    // Boulders are balls of rocks sitting on the surface, half sunk into it
+    // since they only fill air. They depend on the terrain, so they're kept
+    // off the chunk's borders and never spill (see `get_spill`).
+    FeatureRandom random{ settings.seed, chunk.position, 3 };
+    const auto& center_biome = get_biome_info(fields.biomes[Chunk::Width / 2][Chunk::Width / 2]);
+    const int boulders = static_cast<int>(center_biome.boulders)
+        + (random.unit() < center_biome.boulders - static_cast<int>(center_biome.boulders) ? 1 : 0);
+
+    constexpr int max_reach = 2;
+    for (int i = 0; i < boulders; ++i) {
+        const int x = random.range(max_reach, Chunk::Width - max_reach);
+        const int z = random.range(max_reach, Chunk::Width - max_reach);
+        const float radius = 1.5f + random.unit() * 1.5f;
+
+        const int top = chunk.heightmap[x][z];
+        if (top == 0 || top == Chunk::Height) continue;
+
+        const int reach = std::min(static_cast<int>(radius), max_reach);
+        for (int dx = -reach; dx <= reach; ++dx) {
+            for (int dy = -reach; dy <= reach; ++dy) {
+                for (int dz = -reach; dz <= reach; ++dz) {
+                    if (static_cast<float>(dx * dx + dy * dy + dz * dz) <= radius * radius) {
+                        writer.place(x + dx, top + dy, z + dz, VoxelType::ROCKS, VoxelType::NONE);
+                    }
+                }
+            }
+        }
+    }
+}
+
+void WorldGenerator::get_spill(ChunkPosition pos, std::vector<FeatureSpill>& spill) const {
+    FeatureWriter writer{ nullptr, pos, spill };
+    place_ores(settings, writer);
+}
+
+const WorldGenerator& get_default_generator() {
+    static const WorldGenerator generator;
+    return generator;
+}
+
+int get_voxel_height(const Chunk& chunk, int x, int z) {
+    return get_default_generator().get_height(chunk, x, z);
+}
+
+void populate_chunk(Chunk& chunk) {
+    const auto& generator = get_default_generator();
+
+    ColumnFields fields;
+    generator.get_column_fields(chunk.position, fields);
+    generator.populate(chunk, fields);
+
+    std::vector<FeatureSpill> spill;
+    generator.decorate(chunk, fields, spill);
+
+    // Whatever the neighbours spill into it, in a fixed order.
+    for (int dx = -1; dx <= 1; ++dx) {
+        for (int dz = -1; dz <= 1; ++dz) {
+            if (dx == 0 && dz == 0) continue;
+
+            spill.clear();
+            generator.get_spill(chunk.position + ChunkPosition{ dx, 0, dz }, spill);
+            for (const auto& neighbour_spill : spill) {
+                if (neighbour_spill.target == chunk.position) {
+                    apply_feature_spill(chunk, neighbour_spill);
+                }
+            }
+        }
+    }
+    chunk.spill_sources = AllSpillSources;
+}